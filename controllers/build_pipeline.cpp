@@ -0,0 +1,232 @@
+#include "build_pipeline.h"
+#include "controller.h"
+#include "models/microservice_data.h"
+#include "models/source_fingerprint.h"
+#include "utils/tracer.h"
+
+#include <QCryptographicHash>
+#include <QFutureWatcher>
+#include <QSettings>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+namespace {
+struct FingerprintTarget {
+    QString serviceName;
+    QString folderPath;
+};
+}
+
+BuildPipeline::BuildPipeline(
+    Model *model,
+    Controller *controller,
+    const QString &commandName,
+    const QStringList &serviceNames,
+    const std::function<QStringList(MicroserviceData*)> &argumentsFor,
+    QObject *parent)
+    : QObject(parent)
+    , model(model)
+    , controller(controller)
+    , commandName(commandName)
+    , argumentsFor(argumentsFor)
+    , queue(serviceNames)
+    , serviceCount(serviceNames.size())
+    , done(false)
+{
+    QSettings settings(model->getConfigFile(), QSettings::IniFormat);
+    totalSlots = qMax(1, settings.value("Build/jobs", QThread::idealThreadCount()).toInt());
+    freeSlots = totalSlots;
+    skipUnchanged = settings.value("Build/skipUnchanged", true).toBool();
+    ignored = settings.value("Build/ignore", SourceFingerprint::defaultIgnored).toStringList();
+
+    // A build that needs more slots than there are gets all of them
+    foreach (const QString &serviceName, serviceNames) {
+        int slots = settings.value("BuildSlots/" + serviceName, 1).toInt();
+        serviceSlots.insert(serviceName, qBound(1, slots, totalSlots));
+    }
+}
+
+void BuildPipeline::start() {
+    qDebug() << "Building" << queue.size() << "services with" << totalSlots << "job slots";
+    if (skipUnchanged) {
+        computeFingerprints();
+        return;
+    }
+
+    scheduleBuilds();
+    finishIfDone();
+}
+
+void BuildPipeline::computeFingerprints() {
+    QVector<FingerprintTarget> targets;
+    foreach (const QString &serviceName, queue) {
+        MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+        if (microservice) {
+            targets.append({serviceName, QDir(microservice->getDirectory()).filePath(microservice->getFolderName())});
+        }
+    }
+
+    emit progress(QString("%1: checking sources of %2 services...").arg(commandName).arg(targets.size()));
+
+    // Services are fingerprinted in parallel, each one walks its own tree and cache
+    QStringList ignoredNames = ignored;
+    QFutureWatcher<QHash<QString, QByteArray>> *watcher = new QFutureWatcher<QHash<QString, QByteArray>>(this);
+    connect(watcher, &QFutureWatcher<QHash<QString, QByteArray>>::finished, this, [this, watcher]() {
+        skipUnchangedBuilds(watcher->result());
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run([targets, ignoredNames]() {
+        QList<QByteArray> results = QtConcurrent::blockingMapped<QList<QByteArray>>(targets, [&ignoredNames](const FingerprintTarget &target) {
+            return SourceFingerprint::compute(target.serviceName, target.folderPath, ignoredNames);
+        });
+
+        QHash<QString, QByteArray> computed;
+        for (int i = 0; i < targets.size(); ++i) {
+            computed.insert(targets.at(i).serviceName, results.at(i));
+        }
+        return computed;
+    }));
+}
+
+void BuildPipeline::skipUnchangedBuilds(const QHash<QString, QByteArray> &computed) {
+    TraceSpan span("BuildPipeline::skipUnchangedBuilds", "build", commandName);
+    QSettings settings(model->getSaveFile(), QSettings::IniFormat);
+    QString buildCommand = controller->getCommandOptions(commandName).buildCommand;
+
+    // The build command is part of the fingerprint, so another kind of build is not skipped
+    for (auto iter = computed.constBegin(); iter != computed.constEnd(); ++iter) {
+        if (!iter.value().isEmpty()) {
+            fingerprints.insert(iter.key(), QCryptographicHash::hash(buildCommand.toUtf8() + '\0' + iter.value(), QCryptographicHash::Sha256).toHex());
+        }
+    }
+
+    foreach (const QString &serviceName, queue) {
+        QByteArray lastBuilt = settings.value("BuildFingerprints/" + serviceName).toByteArray();
+        if (fingerprints.contains(serviceName) && fingerprints.value(serviceName) == lastBuilt) {
+            queue.removeOne(serviceName);
+            unchanged.append(serviceName);
+        }
+    }
+
+    if (!unchanged.isEmpty()) {
+        qDebug() << "Sources unchanged since the last build:" << unchanged;
+    }
+
+    // A launch can finish right away, so every launch is counted before the first one starts
+    launching += unchanged;
+    foreach (const QString &serviceName, unchanged) {
+        launch(serviceName);
+    }
+
+    scheduleBuilds();
+    finishIfDone();
+}
+
+void BuildPipeline::scheduleBuilds() {
+    // Builds start in order; a large build at the head is not overtaken, so it cannot starve
+    while (!queue.isEmpty() && serviceSlots.value(queue.first()) <= freeSlots) {
+        QString serviceName = queue.takeFirst();
+        MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+        if (!microservice) {
+            failed.append(serviceName + " (removed)");
+            continue;
+        }
+
+        TraceSpan span("BuildPipeline::build", "build", serviceName);
+        int slots = serviceSlots.value(serviceName);
+        freeSlots -= slots;
+        slotsInUse.insert(serviceName, slots);
+        controller->executeBuildAsync(commandName, argumentsFor(microservice), microservice, slots, [this, serviceName](int exitCode) {
+            onBuildFinished(serviceName, exitCode);
+        });
+    }
+
+    reportProgress();
+}
+
+void BuildPipeline::onBuildFinished(const QString &serviceName, int exitCode) {
+    freeSlots += slotsInUse.take(serviceName);
+
+    if (exitCode == 0) {
+        // Only a successful build is remembered, a failed one is repeated next time
+        if (fingerprints.contains(serviceName)) {
+            QSettings settings(model->getSaveFile(), QSettings::IniFormat);
+            settings.setValue("BuildFingerprints/" + serviceName, fingerprints.value(serviceName));
+        }
+        launching.append(serviceName);
+        launch(serviceName);
+    } else {
+        qWarning() << "Build of" << serviceName << "failed with exit code:" << exitCode;
+        failed.append(serviceName + QString(" (build exit code %1)").arg(exitCode));
+    }
+
+    scheduleBuilds();
+    finishIfDone();
+}
+
+void BuildPipeline::launch(const QString &serviceName) {
+    MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+    if (!microservice) {
+        launching.removeOne(serviceName);
+        failed.append(serviceName + " (removed)");
+        return;
+    }
+
+    controller->executeScriptAsync(commandName, argumentsFor(microservice), microservice, [this, serviceName](int exitCode) {
+        onLaunchFinished(serviceName, exitCode);
+    });
+}
+
+void BuildPipeline::onLaunchFinished(const QString &serviceName, int exitCode) {
+    launching.removeOne(serviceName);
+
+    if (exitCode == 0) {
+        started.append(serviceName);
+    } else {
+        failed.append(serviceName + QString(" (exit code %1)").arg(exitCode));
+    }
+
+    reportProgress();
+    finishIfDone();
+}
+
+void BuildPipeline::reportProgress() {
+    if (done) {
+        return;
+    }
+
+    emit progress(QString("%1: building %2, waiting %3, launching %4, done %5 of %6 services (%7/%8 job slots in use)")
+        .arg(commandName)
+        .arg(slotsInUse.size())
+        .arg(queue.size())
+        .arg(launching.size())
+        .arg(started.size() + failed.size())
+        .arg(serviceCount)
+        .arg(totalSlots - freeSlots)
+        .arg(totalSlots));
+}
+
+void BuildPipeline::finishIfDone() {
+    // A launch of a supervised service finishes right away, so this can be reached twice for the last one
+    if (done || !queue.isEmpty() || !slotsInUse.isEmpty() || !launching.isEmpty()) {
+        return;
+    }
+
+    done = true;
+
+    QString summary = QString("%1: started %2 of %3 services")
+        .arg(commandName)
+        .arg(started.size())
+        .arg(serviceCount);
+    if (!unchanged.isEmpty()) {
+        summary += QString(", %1 unchanged without build").arg(unchanged.size());
+    }
+    if (!failed.isEmpty()) {
+        summary += ", failed: " + failed.join(", ");
+    }
+
+    qDebug() << "Build pipeline finished:" << summary;
+    emit finished(summary);
+    deleteLater();
+}
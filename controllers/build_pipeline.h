@@ -0,0 +1,67 @@
+#ifndef BUILD_PIPELINE_H
+#define BUILD_PIPELINE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+#include <functional>
+
+class Controller;
+class Model;
+class MicroserviceData;
+
+// Runs the build phase of a command for several services in parallel and launches each service
+// as soon as its own build succeeded. Builds share a budget of job slots, like the jobserver of
+// GNU make: a build takes the slots of its service and waits while not enough of them are free.
+// The build of a service whose source fingerprint matches its last successful build is skipped.
+class BuildPipeline : public QObject
+{
+    Q_OBJECT
+public:
+    BuildPipeline(
+        Model *model,
+        Controller *controller,
+        const QString &commandName,
+        const QStringList &serviceNames,
+        const std::function<QStringList(MicroserviceData*)> &argumentsFor,
+        QObject *parent = nullptr);
+
+    void start();
+
+signals:
+    void progress(const QString &message);
+    void finished(const QString &summary);
+
+private:
+    void computeFingerprints();
+    void skipUnchangedBuilds(const QHash<QString, QByteArray> &computed);
+    void scheduleBuilds();
+    void onBuildFinished(const QString &serviceName, int exitCode);
+    void launch(const QString &serviceName);
+    void onLaunchFinished(const QString &serviceName, int exitCode);
+    void reportProgress();
+    void finishIfDone();
+
+    Model *model;
+    Controller *controller;
+    QString commandName;
+    std::function<QStringList(MicroserviceData*)> argumentsFor;
+    QStringList queue;
+    QHash<QString, int> slotsInUse;
+    QHash<QString, int> serviceSlots;
+    QHash<QString, QByteArray> fingerprints;
+    QStringList ignored;
+    QStringList launching;
+    QStringList started;
+    QStringList unchanged;
+    QStringList failed;
+    int totalSlots;
+    int freeSlots;
+    int serviceCount;
+    bool skipUnchanged;
+    bool done;
+};
+
+#endif // BUILD_PIPELINE_H
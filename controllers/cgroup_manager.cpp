@@ -0,0 +1,184 @@
+#include "cgroup_manager.h"
+#include "utils/tracer.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+CgroupManager::CgroupManager(const QString &configFile)
+    : enabled(false)
+    , rootCreated(false)
+{
+    QSettings settings(configFile, QSettings::IniFormat);
+
+    settings.beginGroup("Cgroups");
+    enabled = settings.value("enabled", false).toBool();
+    root = settings.value("root", defaultRoot()).toString();
+    defaultLimits.cpuMax = settings.value("cpuMax").toString();
+    defaultLimits.memoryMax = settings.value("memoryMax").toString();
+    defaultLimits.cpuWeight = settings.value("cpuWeight").toString();
+    settings.endGroup();
+
+    foreach (const QString &group, settings.childGroups()) {
+        if (group.startsWith("Cgroup_")) {
+            settings.beginGroup(group);
+
+            CgroupLimits limits;
+            limits.group = settings.value("group").toString();
+            limits.cpuMax = settings.value("cpuMax", defaultLimits.cpuMax).toString();
+            limits.memoryMax = settings.value("memoryMax", defaultLimits.memoryMax).toString();
+            limits.cpuWeight = settings.value("cpuWeight", defaultLimits.cpuWeight).toString();
+            serviceLimits.insert(group.mid(QString("Cgroup_").length()), limits);
+
+            settings.endGroup();
+        }
+    }
+
+    // A shared cgroup has one set of limits, taken from the first of its services
+    for (auto iter = serviceLimits.constBegin(); iter != serviceLimits.constEnd(); ++iter) {
+        const CgroupLimits &limits = iter.value();
+        if (limits.group.isEmpty()) {
+            continue;
+        }
+
+        if (!groupLimits.contains(limits.group)) {
+            groupLimits.insert(limits.group, limits);
+            continue;
+        }
+
+        const CgroupLimits &shared = groupLimits.value(limits.group);
+        if (shared.cpuMax != limits.cpuMax || shared.memoryMax != limits.memoryMax || shared.cpuWeight != limits.cpuWeight) {
+            qWarning() << "Limits of" << iter.key() << "differ from the other services of cgroup" << limits.group << "and are ignored";
+        }
+    }
+
+#if !defined(Q_OS_LINUX)
+    if (enabled) {
+        qWarning() << "cgroups are only supported on Linux";
+        enabled = false;
+    }
+#endif
+}
+
+QString CgroupManager::defaultRoot() const {
+#if defined(Q_OS_UNIX)
+    const QString uid = QString::number(::getuid());
+    return "/sys/fs/cgroup/user.slice/user-" + uid + ".slice/user@" + uid + ".service/app.slice/microservice-launcher";
+#else
+    return QString();
+#endif
+}
+
+bool CgroupManager::isEnabled() const {
+    return enabled;
+}
+
+bool CgroupManager::writeValue(const QString &path, const QString &value) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open" << path << file.errorString();
+        return false;
+    }
+
+    if (file.write(value.toUtf8()) == -1) {
+        qWarning() << "Failed to write" << value << "to" << path << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool CgroupManager::createRoot() {
+    if (rootCreated) {
+        return true;
+    }
+
+    if (!QDir().mkpath(root)) {
+        qWarning() << "Failed to create cgroup" << root << "- is the slice delegated to the user?";
+        return false;
+    }
+
+    // Children of the root get their own cpu and memory controllers; the root itself holds no processes.
+    writeValue(root + "/cgroup.subtree_control", "+cpu +memory");
+    rootCreated = true;
+    return true;
+}
+
+QString CgroupManager::getGroupPath(const QString &serviceName) const {
+    QString group = serviceLimits.value(serviceName).group;
+    return root + "/" + (group.isEmpty() ? serviceName : group);
+}
+
+CgroupLimits CgroupManager::getLimits(const QString &serviceName) const {
+    QString group = serviceLimits.value(serviceName).group;
+    return group.isEmpty() ? serviceLimits.value(serviceName, defaultLimits) : groupLimits.value(group);
+}
+
+QByteArray CgroupManager::prepare(const QString &serviceName) {
+    if (!enabled || !createRoot()) {
+        return QByteArray();
+    }
+
+    TraceSpan span("CgroupManager::prepare", "command", serviceName);
+    QString path = getGroupPath(serviceName);
+    QByteArray procsFile = QFile::encodeName(path + "/cgroup.procs");
+
+    // Limits are written when the cgroup is created, not again for every service started into a shared one
+    if (preparedGroups.contains(path) && QDir(path).exists()) {
+        return procsFile;
+    }
+
+    if (!QDir().mkpath(path)) {
+        qWarning() << "Failed to create cgroup" << path;
+        return QByteArray();
+    }
+
+    CgroupLimits limits = getLimits(serviceName);
+    if (!limits.cpuMax.isEmpty()) {
+        writeValue(path + "/cpu.max", limits.cpuMax);
+    }
+
+    if (!limits.memoryMax.isEmpty()) {
+        writeValue(path + "/memory.max", limits.memoryMax);
+    }
+
+    if (!limits.cpuWeight.isEmpty()) {
+        writeValue(path + "/cpu.weight", limits.cpuWeight);
+    }
+
+    preparedGroups.insert(path);
+    return procsFile;
+}
+
+CgroupUsage CgroupManager::readUsage(const QString &serviceName) const {
+    CgroupUsage usage;
+    if (!enabled) {
+        return usage;
+    }
+
+    QString path = getGroupPath(serviceName);
+
+    QFile memoryFile(path + "/memory.current");
+    if (!memoryFile.open(QIODevice::ReadOnly)) {
+        return usage;
+    }
+    usage.memoryBytes = memoryFile.readAll().trimmed().toLongLong();
+
+    QFile cpuFile(path + "/cpu.stat");
+    if (cpuFile.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> lines = cpuFile.readAll().split('\n');
+        for (auto iter = lines.constBegin(); iter != lines.constEnd(); ++iter) {
+            if (iter->startsWith("usage_usec ")) {
+                usage.cpuUsageUsec = iter->mid(QByteArray("usage_usec ").length()).toLongLong();
+                break;
+            }
+        }
+    }
+
+    usage.valid = true;
+    return usage;
+}
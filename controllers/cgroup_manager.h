@@ -0,0 +1,46 @@
+#ifndef CGROUP_MANAGER_H
+#define CGROUP_MANAGER_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QSet>
+#include <QString>
+
+struct CgroupLimits {
+    QString group;
+    QString cpuMax;
+    QString memoryMax;
+    QString cpuWeight;
+};
+
+struct CgroupUsage {
+    bool valid = false;
+    qint64 memoryBytes = 0;
+    qint64 cpuUsageUsec = 0;
+};
+
+// Places launched services into cgroup v2 subtrees below the user's delegated slice.
+class CgroupManager {
+public:
+    explicit CgroupManager(const QString &configFile);
+    bool isEnabled() const;
+    QByteArray prepare(const QString &serviceName);
+    CgroupUsage readUsage(const QString &serviceName) const;
+
+private:
+    QString defaultRoot() const;
+    QString getGroupPath(const QString &serviceName) const;
+    CgroupLimits getLimits(const QString &serviceName) const;
+    bool writeValue(const QString &path, const QString &value) const;
+    bool createRoot();
+
+    bool enabled;
+    bool rootCreated;
+    QString root;
+    CgroupLimits defaultLimits;
+    QMap<QString, CgroupLimits> serviceLimits;
+    QMap<QString, CgroupLimits> groupLimits;
+    QSet<QString> preparedGroups;
+};
+
+#endif // CGROUP_MANAGER_H
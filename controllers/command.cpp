@@ -7,7 +7,8 @@ Command::Command(
     const QStringList &excludedServices,
     const QString buttonStyle,
     const bool executeForSelected,
-    const QString &scriptName)
+    const QString &scriptName,
+    const CommandOptions &options)
     : name(name)
     , command(command)
     , args(args)
@@ -15,6 +16,7 @@ Command::Command(
     , buttonStyle(buttonStyle)
     , executeForSelected(executeForSelected)
     , scriptName(scriptName)
+    , options(options)
 {}
 
 QString Command::getName() const {
@@ -44,3 +46,7 @@ QStringList Command::getArgs() const {
 bool Command::getExecuteForSelected() const {
     return executeForSelected;
 }
+
+CommandOptions Command::getOptions() const {
+    return options;
+}
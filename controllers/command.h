@@ -1,8 +1,40 @@
 #ifndef COMMAND_H
 #define COMMAND_H
 
+#include "supervisor.h"
+#include "models/microservice_status.h"
+
 #include <QStringList>
 
+enum class PortCheck {
+    None,
+    Warn,
+    Block
+};
+
+// What a command does to a service, so its effect can be recorded in the status history
+enum class CommandRole {
+    None,
+    Start,
+    Stop,
+    Restart
+};
+
+// Optional behaviour of a command, read from its Command_<Name> section.
+struct CommandOptions {
+    SupervisionPolicy supervisionPolicy;
+    QVector<MicroserviceStatus> requiredStatuses;
+    bool batch = false;
+    bool useWorker = false;
+    PortCheck portCheck = PortCheck::None;
+    CommandRole role = CommandRole::None;
+    int rollingBatchSize = 0;   // restart selected services this many at a time, 0 runs them all one after another
+    int readyTimeoutSec = 120;  // time a restarted service has to become ready
+    int maxFailures = 1;        // failed services after which no further batch is started
+    bool autoRestart = false;   // run the command again when a service it started goes down on its own
+    QString buildCommand;       // passed to the script instead of the command to build a service before it is launched
+};
+
 class Command {
 public:
     explicit Command(
@@ -12,7 +44,8 @@ public:
         const QStringList &excludedServices,
         const QString buttonStyle,
         const bool executeForSelected,
-        const QString &scriptName);
+        const QString &scriptName,
+        const CommandOptions &options = CommandOptions());
     QString getName() const;
     QString getCommand() const;
     QString getButtonStyle() const;
@@ -20,6 +53,7 @@ public:
     QStringList getExcludedServices() const;
     QStringList getArgs() const;
     bool getExecuteForSelected() const;
+    CommandOptions getOptions() const;
 
 private:
     QString name;
@@ -29,6 +63,7 @@ private:
     QString buttonStyle;
     bool executeForSelected;
     QString scriptName;
+    CommandOptions options;
 };
 
 #endif // COMMAND_H
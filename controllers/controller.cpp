@@ -1,16 +1,55 @@
 #include "controller.h"
 #include "models/microservice_data.h"
+#include "utils/tracer.h"
+#include "utils/shell_worker.h"
+#include "models/status_history.h"
+#include "utils/metrics.h"
+#include "utils/output_log.h"
 
 #include <QtCore/qprocess.h>
 #include <QSettings>
+#include <QDir>
 #include <QCoreApplication>
 #include <QMessageBox>
 #include <QStandardPaths>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QSharedPointer>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+bool startsService(CommandRole role) {
+    return role == CommandRole::Start || role == CommandRole::Restart;
+}
+}
 
 Controller::Controller(Model *model)
     : model(model)
+    , supervisor(new Supervisor(this))
+    , cgroupManager(model->getConfigFile())
+    , metricsExporter(new MetricsExporter(model->getConfigFile(), this))
+    , healthChecker(new HealthChecker(model->getConfigFile(), this))
+    , crashMonitor(new CrashMonitor(model->getConfigFile(), this))
+    , sourceWatcher(new SourceWatcher(model->getConfigFile(), this))
 {
     loadCommandsFromConfig();
+    connect(supervisor, &Supervisor::stateChanged, this, &Controller::microserviceStateChanged);
+    connect(healthChecker, &HealthChecker::checkRequested, this, &Controller::checkHealth);
+    connect(healthChecker, &HealthChecker::healthChecked, this, &Controller::applyHealthResult);
+    connect(crashMonitor, &CrashMonitor::checkRequested, this, &Controller::detectCrashes);
+    connect(crashMonitor, &CrashMonitor::restartRequested, this, &Controller::restartCrashedService);
+    connect(crashMonitor, &CrashMonitor::crashed, this, &Controller::applyCrash);
+    connect(sourceWatcher, &SourceWatcher::sourcesChanged, this, &Controller::applySourceChange);
 }
 
 void Controller::loadCommandsFromConfig() {
@@ -36,7 +75,58 @@ void Controller::loadCommandsFromConfig() {
                 args = settings.value("args").toStringList();
             }
 
-            addCommand(name, command, args, excludedServices, buttonStyle, executeForSelected, scriptName);
+            CommandOptions options;
+            SupervisionPolicy &supervisionPolicy = options.supervisionPolicy;
+            supervisionPolicy.supervised = settings.value("supervised", false).toBool();
+            supervisionPolicy.restartPolicy = Supervisor::restartPolicyFromString(settings.value("restartPolicy", "on-failure").toString());
+            supervisionPolicy.restartDelayMs = settings.value("restartDelayMs", supervisionPolicy.restartDelayMs).toInt();
+            supervisionPolicy.maxRestartDelayMs = settings.value("maxRestartDelayMs", supervisionPolicy.maxRestartDelayMs).toInt();
+            supervisionPolicy.crashLoopLimit = settings.value("crashLoopLimit", supervisionPolicy.crashLoopLimit).toInt();
+            supervisionPolicy.crashLoopWindowSec = settings.value("crashLoopWindowSec", supervisionPolicy.crashLoopWindowSec).toInt();
+
+            foreach (const QString &statusName, settings.value("requiredStatus").toStringList()) {
+                MicroserviceStatus status;
+                if (microserviceStatusFromString(statusName, status)) {
+                    options.requiredStatuses.append(status);
+                } else {
+                    qWarning() << "Unknown status" << statusName << "in command" << name;
+                }
+            }
+
+            options.batch = settings.value("batch", false).toBool();
+            options.useWorker = settings.value("useWorker", false).toBool();
+
+            // A script run in the worker cannot get a session or cgroup of its own, so services are not started there
+            if (options.useWorker && executeForSelected) {
+                qWarning() << "useWorker is ignored for command" << name << "since it is executed for selected services";
+                options.useWorker = false;
+            }
+
+            QString portCheck = settings.value("checkPorts").toString();
+            if (portCheck.compare("warn", Qt::CaseInsensitive) == 0) {
+                options.portCheck = PortCheck::Warn;
+            } else if (portCheck.compare("block", Qt::CaseInsensitive) == 0) {
+                options.portCheck = PortCheck::Block;
+            }
+
+            QString role = settings.value("role").toString();
+            if (role.compare("start", Qt::CaseInsensitive) == 0) {
+                options.role = CommandRole::Start;
+            } else if (role.compare("stop", Qt::CaseInsensitive) == 0) {
+                options.role = CommandRole::Stop;
+            } else if (role.compare("restart", Qt::CaseInsensitive) == 0) {
+                options.role = CommandRole::Restart;
+            } else if (!role.isEmpty()) {
+                qWarning() << "Unknown role" << role << "in command" << name;
+            }
+
+            options.rollingBatchSize = settings.value("rollingBatchSize", options.rollingBatchSize).toInt();
+            options.readyTimeoutSec = settings.value("readyTimeoutSec", options.readyTimeoutSec).toInt();
+            options.maxFailures = settings.value("maxFailures", options.maxFailures).toInt();
+            options.autoRestart = settings.value("autoRestart", false).toBool();
+            options.buildCommand = settings.value("buildCommand").toString();
+
+            addCommand(name, command, args, excludedServices, buttonStyle, executeForSelected, scriptName, options);
 
             settings.endGroup();
         }
@@ -44,13 +134,254 @@ void Controller::loadCommandsFromConfig() {
 }
 
 void Controller::refresh() {
+    TraceSpan span("Controller::refresh", "status");
+    QElapsedTimer timer;
+    timer.start();
+
+    ProcessTree processTree = ProcessTree::snapshot();
     QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
     QMap<QString, MicroserviceData*>::const_iterator iter;
     for (iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
-        iter.value()->refreshCheckboxState();
+        MicroserviceStatus previous = iter.value()->getStatus();
+        iter.value()->refreshCheckboxState(processTree);
+        updateResourceUsage(iter.value());
+
+        // Supervised services are restarted by the supervisor, a debugged service is stopped by the debugger
+        if (previous != MicroserviceStatus::Inactive && previous != MicroserviceStatus::Debug
+            && iter.value()->getStatus() == MicroserviceStatus::Inactive && crashMonitor->isWatched(iter.key())
+            && !supervisor->isSupervised(iter.key()) && !commandsInProgress.contains(iter.key())) {
+            crashMonitor->serviceExited(iter.value());
+        }
     }
+
+    Metrics::instance().observe("launcher_refresh_duration_seconds", {}, timer.elapsed() / 1000.0);
+    checkHealth();
 };
 
+void Controller::detectCrashes() {
+    TraceSpan span("Controller::detectCrashes", "status");
+
+    // Only running services started by the launcher are checked, so other services cost nothing here
+    ProcessTree processTree;
+    bool snapshotTaken = false;
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        MicroserviceStatus status = iter.value()->getStatus();
+        if (status == MicroserviceStatus::Inactive || status == MicroserviceStatus::Debug || !crashMonitor->isWatched(iter.key())
+            || supervisor->isSupervised(iter.key()) || commandsInProgress.contains(iter.key())) {
+            continue;
+        }
+
+        if (!snapshotTaken) {
+            processTree = ProcessTree::snapshot();
+            snapshotTaken = true;
+        }
+
+        iter.value()->refreshCheckboxState(processTree);
+        if (iter.value()->getStatus() == MicroserviceStatus::Inactive) {
+            crashMonitor->serviceExited(iter.value());
+            emit microserviceStateChanged(iter.key());
+        }
+    }
+}
+
+void Controller::restartCrashedService(const QString &serviceName, const QString &commandName, const QStringList &arguments) {
+    MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+    if (!microservice || !commands.contains(commandName)) {
+        return;
+    }
+
+    qDebug() << "Restarting crashed service" << serviceName << "with command" << commandName;
+    executeScriptAsync(commandName, arguments, microservice, [this, serviceName](int exitCode) {
+        if (exitCode != 0) {
+            qWarning() << "Restart of" << serviceName << "failed with exit code:" << exitCode;
+        }
+        emit microserviceStateChanged(serviceName);
+    });
+}
+
+void Controller::applyCrash(const QString &serviceName, const QString &message, bool circuitOpen) {
+    MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+    if (!microservice) {
+        return;
+    }
+
+    microservice->setSupervisionInfo(message, true, crashMonitor->getLastLines(microservice).join("\n"));
+    emit microserviceCrashed(serviceName, message, circuitOpen);
+}
+
+void Controller::checkHealth() {
+    QVector<HealthTarget> targets;
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        MicroserviceData *microservice = iter.value();
+        HealthTarget target = healthChecker->getTarget(microservice->getName(), microservice->getHealthEndpoint());
+        if (target.port <= 0) {
+            continue;
+        }
+
+        // Stopped services have no health, only their status
+        if (microservice->getStatus() == MicroserviceStatus::Inactive) {
+            microservice->setHealth(HealthState::Unknown, QString());
+            continue;
+        }
+
+        targets.append(target);
+    }
+
+    healthChecker->check(targets);
+}
+
+bool Controller::hasHealthEndpoint(MicroserviceData *microservice) const {
+    return healthChecker->getTarget(microservice->getName(), microservice->getHealthEndpoint()).port > 0;
+}
+
+void Controller::applyHealthResult(const QString &serviceName, const HealthResult &result) {
+    MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+    if (!microservice || microservice->getStatus() == MicroserviceStatus::Inactive) {
+        return;
+    }
+
+    microservice->setHealth(result.state, HealthChecker::describe(result));
+
+    Metrics &metrics = Metrics::instance();
+    if (result.latencyUs >= 0) {
+        metrics.observe("launcher_health_check_duration_seconds", {{"service", serviceName}}, result.latencyUs / 1000000.0);
+    }
+
+    foreach (HealthState state, QVector<HealthState>({HealthState::Healthy, HealthState::Degraded, HealthState::Down})) {
+        metrics.setGauge("launcher_service_health", {{"service", serviceName}, {"state", healthStateToString(state)}}, state == result.state ? 1 : 0);
+    }
+}
+
+void Controller::watchSources() {
+    QHash<QString, QString> folders;
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        if (sourceWatcher->isConfigured(iter.key())) {
+            folders.insert(iter.key(), QDir(iter.value()->getDirectory()).filePath(iter.value()->getFolderName()));
+        }
+    }
+
+    sourceWatcher->setServices(folders);
+}
+
+void Controller::applySourceChange(const QString &serviceName, const QString &commandName, const QStringList &commandArgs) {
+    MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+    if (!microservice) {
+        return;
+    }
+
+    if (microservice->getStatus() == MicroserviceStatus::Inactive) {
+        qDebug() << "Sources of" << serviceName << "changed, but the service is not running";
+        return;
+    }
+
+    QString command = commandName.isEmpty() ? getCommandForRole(CommandRole::Restart) : commandName;
+    if (!commands.contains(command)) {
+        qWarning() << "No restart command for watched service" << serviceName;
+        return;
+    }
+
+    emit sourcesChanged(serviceName, command, commandArgs);
+}
+
+void Controller::beginCommand(const QString &serviceName) {
+    // The files a command writes (logs, pid files) must not restart the service it works on
+    if (commandsInProgress[serviceName]++ == 0) {
+        sourceWatcher->setPaused(serviceName, true);
+    }
+}
+
+void Controller::endCommand(const QString &serviceName) {
+    if (--commandsInProgress[serviceName] <= 0) {
+        commandsInProgress.remove(serviceName);
+        sourceWatcher->setPaused(serviceName, false);
+    }
+}
+
+void Controller::recordCommandIssued(CommandRole role, MicroserviceData *microservice, const QString &commandName, const QStringList &additionalArgs) const {
+    switch (role) {
+    case CommandRole::Start:
+    case CommandRole::Restart: {
+        StatusHistory::instance()->recordStart(microservice->getName(), microservice->getPorts());
+
+        // Batch commands have no per-service invocation to repeat, so their services are only watched
+        CommandOptions options = commands.contains(commandName) ? commands.value(commandName)->getOptions() : CommandOptions();
+        bool autoRestart = options.autoRestart && !options.batch && !options.supervisionPolicy.supervised;
+        crashMonitor->recordStart(microservice->getName(), commandName, additionalArgs, options.supervisionPolicy, autoRestart);
+        if (!supervisor->isSupervised(microservice->getName())) {
+            microservice->setSupervisionInfo(QString(), false);
+        }
+        break;
+    }
+    case CommandRole::Stop:
+        StatusHistory::instance()->recordStop(microservice->getName());
+        crashMonitor->recordStop(microservice->getName());
+
+        // Otherwise the supervisor would take the exit caused by the stop script for a crash and restart the service
+        supervisor->stop(microservice->getName());
+        break;
+    case CommandRole::None:
+        break;
+    }
+}
+
+void Controller::recordCommandMetrics(const QString &commandName, const QString &serviceName, int exitCode, qint64 elapsedMs) const {
+    Metrics &metrics = Metrics::instance();
+    metrics.observe("launcher_command_duration_seconds", {{"command", commandName}}, elapsedMs / 1000.0);
+    metrics.increment("launcher_commands_total", {{"command", commandName}, {"result", exitCode == 0 ? "success" : "failure"}});
+
+    if (!serviceName.isEmpty()) {
+        metrics.setGauge("launcher_command_exit_code", {{"command", commandName}, {"service", serviceName}}, exitCode);
+    }
+}
+
+bool Controller::isSupervised(const QString &serviceName) const {
+    return supervisor->isSupervised(serviceName);
+}
+
+void Controller::updateResourceUsage(MicroserviceData *microservice) const {
+    if (!cgroupManager.isEnabled()) {
+        return;
+    }
+
+    CgroupUsage usage = cgroupManager.readUsage(microservice->getName());
+    if (!usage.valid) {
+        microservice->setResourceUsage(QString());
+        return;
+    }
+
+    microservice->setResourceUsage(QString("mem %1 MiB, cpu %2 s")
+        .arg(usage.memoryBytes / (1024 * 1024))
+        .arg(usage.cpuUsageUsec / 1000000.0, 0, 'f', 1));
+}
+
+std::function<void()> Controller::createChildProcessModifier(MicroserviceData *microservice, bool joinCgroup) {
+#if defined(Q_OS_UNIX)
+    // Only scripts starting the service join its cgroup; a stop script must not be limited or counted with it
+    QByteArray cgroupProcsFile = joinCgroup ? cgroupManager.prepare(microservice->getName()) : QByteArray();
+
+    // Runs in the child between fork and exec, so only async-signal-safe calls are used.
+    return [cgroupProcsFile]() {
+        ::setsid();
+
+        if (!cgroupProcsFile.isEmpty()) {
+            int fd = ::open(cgroupProcsFile.constData(), O_WRONLY | O_CLOEXEC);
+            if (fd != -1) {
+                ssize_t written = ::write(fd, "0", 1);
+                Q_UNUSED(written);
+                ::close(fd);
+            }
+        }
+    };
+#else
+    Q_UNUSED(microservice);
+    Q_UNUSED(joinCgroup);
+    return std::function<void()>();
+#endif
+}
+
 void Controller::selectAll() {
     QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
     QMap<QString, MicroserviceData*>::const_iterator iter;
@@ -67,11 +398,16 @@ void Controller::deselectAll() {
     }
 };
 
-void Controller::selectDetermined(const QString &saveName) {
+QStringList Controller::getSaveServices(const QString &saveName) const {
     QSettings settings(model->getConfigFile(), QSettings::IniFormat);
     settings.beginGroup("Save");
-    QStringList checkboxNames = settings.value(saveName).toStringList();
+    QStringList serviceNames = settings.value(saveName).toStringList();
     settings.endGroup();
+    return serviceNames;
+}
+
+void Controller::selectDetermined(const QString &saveName) {
+    QStringList checkboxNames = getSaveServices(saveName);
 
     deselectAll();
     MicroserviceDataMap microservices = model->getMicroservices();
@@ -82,34 +418,123 @@ void Controller::selectDetermined(const QString &saveName) {
     }
 }
 
-void Controller::executeScript(const QString &commandName, const QStringList &additionalArgs) {
+void Controller::executeScript(const QString &commandName, const QStringList &additionalArgs, MicroserviceData *microservice) {
+    TraceSpan span("Controller::executeScript", "command", commandName);
     QString scriptName = commands.value(commandName)->getScriptName();
 
     QProcess process;
     QStringList args;
     args << commands.value(commandName)->getCommand()
-         << model->getDirectory()
+         << (microservice ? microservice->getDirectory() : model->getDirectory())
          << additionalArgs
          << QString(APP_VERSION);
 
+    QString program = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/" + scriptName;
+
+    CommandOptions options = commands.value(commandName)->getOptions();
+    if (microservice) {
+        recordCommandIssued(options.role, microservice, commandName, additionalArgs);
+    }
+
+    if (microservice && options.supervisionPolicy.supervised) {
+        supervisor->start(microservice, program, args, options.supervisionPolicy, createChildProcessModifier(microservice, true));
+        return;
+    }
+
+    // The window is not blocked by a command in the worker; its output and exit code are logged as they arrive
+    if (options.useWorker && !microservice) {
+        qDebug() << "Submitting script to shell worker:" << scriptName << "with args:" << args;
+        QElapsedTimer timer;
+        timer.start();
+        int requestId = ShellWorker::instance()->submit("MICROSERVICE_LAUNCHER_DIRECTORIES=" + ShellWorker::quote(model->getDirectories().join(":"))
+                                                        + " " + ShellWorker::commandLine(program, args));
+        if (requestId == -1) {
+            recordCommandMetrics(commandName, QString(), -1, timer.elapsed());
+            return;
+        }
+
+        QSharedPointer<QMetaObject::Connection> outputConnection(new QMetaObject::Connection);
+        *outputConnection = connect(ShellWorker::instance(), &ShellWorker::outputReceived, this, [requestId](int outputId, const QByteArray &line) {
+            if (outputId == requestId) {
+                qDebug() << "Output:" << line;
+            }
+        });
+
+        QSharedPointer<QMetaObject::Connection> connection(new QMetaObject::Connection);
+        *connection = connect(ShellWorker::instance(), &ShellWorker::finished, this,
+            [this, connection, outputConnection, requestId, commandName, timer](int finishedId, int exitCode) {
+                if (finishedId != requestId) {
+                    return;
+                }
+
+                disconnect(*connection);
+                disconnect(*outputConnection);
+                recordCommandMetrics(commandName, QString(), exitCode, timer.elapsed());
+                qDebug() << "Command" << commandName << "finished in shell worker with exit code:" << exitCode;
+            });
+        return;
+    }
+
     qDebug() << "Starting script:" << scriptName << "with args:" << args;
-    process.setProgram(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/" + scriptName);
+    process.setProgram(program);
     process.setArguments(args);
 
-    connect(&process, &QProcess::readyReadStandardOutput, [&process]() {
-        qDebug() << "Output:" << process.readAllStandardOutput();
+    if (!microservice) {
+        QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+        environment.insert("MICROSERVICE_LAUNCHER_DIRECTORIES", model->getDirectories().join(":"));
+        process.setProcessEnvironment(environment);
+    }
+
+    #if defined(Q_OS_UNIX)
+        if (microservice) {
+            // Everything the script spawns stays in this session (and cgroup), so it can be found and stopped later.
+            process.setChildProcessModifier(createChildProcessModifier(microservice, startsService(options.role)));
+        }
+    #endif
+
+    // The output is kept per service, so it can be shown when the service goes down later
+    QString serviceName = microservice ? microservice->getName() : QString();
+    connect(&process, &QProcess::readyReadStandardOutput, [&process, serviceName]() {
+        QByteArray output = process.readAllStandardOutput();
+        qDebug() << "Output:" << output;
+        OutputLog::instance().append(serviceName, output);
     });
-    connect(&process, &QProcess::readyReadStandardError, [&process]() {
-        qDebug() << "Error:" << process.readAllStandardError();
+    connect(&process, &QProcess::readyReadStandardError, [&process, serviceName]() {
+        QByteArray error = process.readAllStandardError();
+        qDebug() << "Error:" << error;
+        OutputLog::instance().append(serviceName, error);
     });
 
+    QElapsedTimer timer;
+    timer.start();
+
+    // The files the script writes while the window waits for it must not restart the service
+    if (microservice) {
+        beginCommand(serviceName);
+    }
+
     process.start();
     if (!process.waitForStarted()) {
         qDebug() << "Failed to start script:" << scriptName << "Error:" << process.errorString();
+        recordCommandMetrics(commandName, microservice ? microservice->getName() : QString(), -1, timer.elapsed());
+        if (microservice) {
+            endCommand(serviceName);
+        }
         return;
     }
 
+    int sessionId = static_cast<int>(process.processId());
     process.waitForFinished();
+    if (microservice) {
+        endCommand(serviceName);
+    }
+    recordCommandMetrics(commandName, microservice ? microservice->getName() : QString(), process.exitCode(), timer.elapsed());
+
+    // Only a script starting the service leaves it behind; processes of other scripts are not the service
+    if (microservice && startsService(options.role) && !ProcessTree::snapshot().getPidsInSession(sessionId).isEmpty()) {
+        qDebug() << "Script left running processes in session" << sessionId << "for" << microservice->getName();
+        microservice->setLaunchSessionId(sessionId);
+    }
 
     if (process.exitCode() == 0) {
         qDebug() << "Command executed successfully.";
@@ -118,6 +543,378 @@ void Controller::executeScript(const QString &commandName, const QStringList &ad
     }
 }
 
+void Controller::executeScriptAsync(const QString &commandName, const QStringList &additionalArgs, MicroserviceData *microservice, const std::function<void(int exitCode)> &onFinished) {
+    TraceSpan span("Controller::executeScriptAsync", "command", commandName);
+    QString scriptName = commands.value(commandName)->getScriptName();
+    QString serviceName = microservice->getName();
+
+    QStringList args;
+    args << commands.value(commandName)->getCommand()
+         << microservice->getDirectory()
+         << additionalArgs
+         << QString(APP_VERSION);
+
+    QString program = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/" + scriptName;
+
+    CommandOptions options = commands.value(commandName)->getOptions();
+    recordCommandIssued(options.role, microservice, commandName, additionalArgs);
+
+    // The supervisor owns the process of a supervised service, so the command is done once it is started
+    if (options.supervisionPolicy.supervised) {
+        supervisor->start(microservice, program, args, options.supervisionPolicy, createChildProcessModifier(microservice, true));
+        onFinished(0);
+        return;
+    }
+
+    // A service is not checked for crashes while a command for it runs, e.g. between the stop and start of a restart
+    beginCommand(serviceName);
+    std::function<void(int)> finish = [this, serviceName, onFinished](int exitCode) {
+        endCommand(serviceName);
+        onFinished(exitCode);
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+
+    qDebug() << "Starting script:" << scriptName << "with args:" << args;
+    QProcess *process = new QProcess(this);
+    process->setProgram(program);
+    process->setArguments(args);
+
+    #if defined(Q_OS_UNIX)
+        process->setChildProcessModifier(createChildProcessModifier(microservice, startsService(options.role)));
+    #endif
+
+    connect(process, &QProcess::readyReadStandardOutput, process, [process, serviceName]() {
+        QByteArray output = process->readAllStandardOutput();
+        qDebug() << "Output:" << output;
+        OutputLog::instance().append(serviceName, output);
+    });
+    connect(process, &QProcess::readyReadStandardError, process, [process, serviceName]() {
+        QByteArray error = process->readAllStandardError();
+        qDebug() << "Error:" << error;
+        OutputLog::instance().append(serviceName, error);
+    });
+
+    // The session is known only while the script runs; it is remembered when processes are left in it
+    QSharedPointer<int> sessionId(new int(0));
+    connect(process, &QProcess::started, process, [process, sessionId]() {
+        *sessionId = static_cast<int>(process->processId());
+    });
+
+    bool recordSession = startsService(options.role);
+    connect(process, &QProcess::finished, this, [this, process, sessionId, recordSession, commandName, serviceName, timer, finish](int exitCode) {
+        recordCommandMetrics(commandName, serviceName, exitCode, timer.elapsed());
+
+        MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+        if (microservice && recordSession && !ProcessTree::snapshot().getPidsInSession(*sessionId).isEmpty()) {
+            qDebug() << "Script left running processes in session" << *sessionId << "for" << serviceName;
+            microservice->setLaunchSessionId(*sessionId);
+        }
+
+        qDebug() << "Command" << commandName << "for" << serviceName << "finished with exit code:" << exitCode;
+        process->deleteLater();
+        finish(exitCode);
+    });
+
+    connect(process, &QProcess::errorOccurred, this, [this, process, commandName, serviceName, timer, finish](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) {
+            return;
+        }
+
+        qDebug() << "Failed to start script for" << serviceName << "Error:" << process->errorString();
+        recordCommandMetrics(commandName, serviceName, -1, timer.elapsed());
+        process->deleteLater();
+        finish(-1);
+    });
+
+    process->start();
+}
+
+void Controller::executeBuildAsync(const QString &commandName, const QStringList &additionalArgs, MicroserviceData *microservice, int jobs, const std::function<void(int exitCode)> &onFinished) {
+    TraceSpan span("Controller::executeBuildAsync", "build", commandName);
+    QString scriptName = commands.value(commandName)->getScriptName();
+    QString serviceName = microservice->getName();
+
+    // The build is the command's script called with buildCommand instead of command
+    QStringList args;
+    args << commands.value(commandName)->getOptions().buildCommand
+         << microservice->getDirectory()
+         << additionalArgs
+         << QString(APP_VERSION);
+
+    // Build tools are told how many job slots they got, e.g. make -j"$MICROSERVICE_LAUNCHER_BUILD_JOBS"
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("MICROSERVICE_LAUNCHER_BUILD", "1");
+    environment.insert("MICROSERVICE_LAUNCHER_BUILD_JOBS", QString::number(jobs));
+
+    qDebug() << "Starting build:" << scriptName << "for" << serviceName << "with" << jobs << "jobs and args:" << args;
+    QProcess *process = new QProcess(this);
+    process->setProgram(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/" + scriptName);
+    process->setArguments(args);
+    process->setProcessEnvironment(environment);
+    process->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(process, &QProcess::readyReadStandardOutput, process, [process, serviceName]() {
+        QByteArray output = process->readAllStandardOutput();
+        qDebug() << "Build output:" << serviceName << output;
+        OutputLog::instance().append(serviceName, output);
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Build output written into the service folder must not restart the service
+    beginCommand(serviceName);
+
+    connect(process, &QProcess::finished, this, [this, process, serviceName, timer, onFinished](int exitCode, QProcess::ExitStatus exitStatus) {
+        endCommand(serviceName);
+        if (exitStatus == QProcess::CrashExit) {
+            exitCode = -1;
+        }
+
+        Metrics &metrics = Metrics::instance();
+        metrics.observe("launcher_build_duration_seconds", {{"service", serviceName}}, timer.elapsed() / 1000.0);
+        metrics.increment("launcher_builds_total", {{"result", exitCode == 0 ? "success" : "failure"}});
+
+        qDebug() << "Build of" << serviceName << "finished with exit code:" << exitCode << "in" << timer.elapsed() << "ms";
+        process->deleteLater();
+        onFinished(exitCode);
+    });
+
+    connect(process, &QProcess::errorOccurred, this, [this, process, serviceName, onFinished](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) {
+            return;
+        }
+
+        qDebug() << "Failed to start build for" << serviceName << "Error:" << process->errorString();
+        endCommand(serviceName);
+        process->deleteLater();
+        onFinished(-1);
+    });
+
+    process->start();
+}
+
+void Controller::executeBatchScript(const QString &commandName, const QVector<MicroserviceData*> &microservices, const QStringList &commandArgs, const std::function<void(const QMap<QString, int> &results)> &onFinished) {
+    TraceSpan span("Controller::executeBatchScript", "command", commandName);
+    QString scriptName = commands.value(commandName)->getScriptName();
+    CommandRole role = commands.value(commandName)->getOptions().role;
+
+    // Services the script does not report on are counted as failed
+    struct BatchState {
+        QMap<QString, int> results;
+        QHash<QString, int> pids;
+        QByteArray outputBuffer;
+        int sessionId = 0;
+    };
+    QSharedPointer<BatchState> state(new BatchState);
+
+    QByteArray manifest;
+    QStringList serviceNames;
+    for (auto iter = microservices.constBegin(); iter != microservices.constEnd(); ++iter) {
+        QJsonArray ports;
+        foreach (int port, (*iter)->getPorts()) {
+            ports.append(port);
+        }
+
+        QJsonObject entry;
+        entry.insert("name", (*iter)->getName());
+        entry.insert("folder", (*iter)->getFolderName());
+        entry.insert("directory", (*iter)->getDirectory());
+        entry.insert("shortName", (*iter)->getShortName());
+        entry.insert("pid", (*iter)->getPIDByPorts());
+        entry.insert("status", microserviceStatusToString((*iter)->getStatus()));
+        entry.insert("ports", ports);
+        entry.insert("tags", QJsonArray::fromStringList((*iter)->getTags()));
+        entry.insert("flags", QJsonArray::fromStringList((*iter)->getEnabledFlags()));
+        entry.insert("args", QJsonArray::fromStringList(commandArgs));
+
+        // One script cannot be in the cgroup of every service, so it places each service itself
+        if (cgroupManager.isEnabled() && startsService(role)) {
+            QByteArray cgroupProcsFile = cgroupManager.prepare((*iter)->getName());
+            if (!cgroupProcsFile.isEmpty()) {
+                entry.insert("cgroup", QString::fromUtf8(cgroupProcsFile));
+            }
+        }
+
+        manifest += QJsonDocument(entry).toJson(QJsonDocument::Compact) + '\n';
+        state->results.insert((*iter)->getName(), -1);
+        serviceNames << (*iter)->getName();
+        beginCommand((*iter)->getName());
+        recordCommandIssued(role, *iter, commandName);
+    }
+
+    QStringList args;
+    args << commands.value(commandName)->getCommand()
+         << model->getDirectory()
+         << commandArgs
+         << QString(APP_VERSION);
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("MICROSERVICE_LAUNCHER_BATCH", "1");
+    environment.insert("MICROSERVICE_LAUNCHER_DIRECTORIES", model->getDirectories().join(":"));
+
+    qDebug() << "Starting batch script:" << scriptName << "for" << microservices.size() << "services with args:" << args;
+    QProcess *process = new QProcess(this);
+    process->setProcessEnvironment(environment);
+    process->setProgram(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/" + scriptName);
+    process->setArguments(args);
+
+    #if defined(Q_OS_UNIX)
+        // The script gets a session of its own; for a single service it also goes into its cgroup
+        if (microservices.size() == 1) {
+            process->setChildProcessModifier(createChildProcessModifier(microservices.first(), startsService(role)));
+        } else {
+            process->setChildProcessModifier([]() {
+                ::setsid();
+            });
+        }
+    #endif
+
+    connect(process, &QProcess::readyReadStandardOutput, process, [process, state]() {
+        state->outputBuffer += process->readAllStandardOutput();
+
+        int newline;
+        while ((newline = state->outputBuffer.indexOf('\n')) != -1) {
+            QByteArray line = state->outputBuffer.left(newline).trimmed();
+            state->outputBuffer.remove(0, newline + 1);
+
+            QJsonObject result = QJsonDocument::fromJson(line).object();
+            if (result.contains("name") && state->results.contains(result.value("name").toString())) {
+                QString name = result.value("name").toString();
+                state->results.insert(name, result.value("exitCode").toInt(-1));
+                state->pids.insert(name, result.value("pid").toVariant().toInt());
+                qDebug() << "Result:" << name << result.value("exitCode").toInt(-1) << result.value("message").toString();
+            } else if (!line.isEmpty()) {
+                qDebug() << "Output:" << line;
+            }
+        }
+    });
+    connect(process, &QProcess::readyReadStandardError, process, [process]() {
+        qDebug() << "Error:" << process->readAllStandardError();
+    });
+
+    connect(process, &QProcess::started, process, [process, state]() {
+        state->sessionId = static_cast<int>(process->processId());
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Called once, when the script finished or could not be started
+    auto finish = [this, process, state, serviceNames, commandName, role, timer, onFinished](int exitCode) {
+        for (auto iter = serviceNames.constBegin(); iter != serviceNames.constEnd(); ++iter) {
+            endCommand(*iter);
+        }
+
+        recordCommandMetrics(commandName, QString(), exitCode, timer.elapsed());
+        for (auto iter = state->results.constBegin(); iter != state->results.constEnd(); ++iter) {
+            Metrics::instance().setGauge("launcher_command_exit_code", {{"command", commandName}, {"service", iter.key()}}, iter.value());
+        }
+
+        // A service the script started with setsid is tracked by the session of its reported pid. The
+        // script's own session is only used when it ran for a single service, since it would stand
+        // for all of them. Scripts that do not start services leave no sessions to track.
+        ProcessTree processTree = ProcessTree::snapshot();
+        for (auto iter = state->results.constBegin(); iter != state->results.constEnd(); ++iter) {
+            MicroserviceData *microservice = model->getMicroservices().value(iter.key());
+            if (!microservice || iter.value() != 0 || !startsService(role)) {
+                continue;
+            }
+
+            int pid = state->pids.value(iter.key());
+            int sessionId = pid > 0 && processTree.contains(pid) ? processTree.value(pid).sessionId : 0;
+            if (sessionId > 0 && sessionId != state->sessionId) {
+                microservice->setLaunchSessionId(sessionId);
+            } else if (state->results.size() == 1 && !processTree.getPidsInSession(state->sessionId).isEmpty()) {
+                microservice->setLaunchSessionId(state->sessionId);
+            }
+        }
+
+        process->deleteLater();
+        onFinished(state->results);
+    };
+
+    connect(process, &QProcess::finished, this, [finish](int exitCode) {
+        qDebug() << "Batch script finished with exit code:" << exitCode;
+        finish(exitCode);
+    });
+    connect(process, &QProcess::errorOccurred, this, [process, scriptName, finish](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) {
+            return;
+        }
+
+        qDebug() << "Failed to start script:" << scriptName << "Error:" << process->errorString();
+        finish(-1);
+    });
+
+    process->start();
+    process->write(manifest);
+    process->closeWriteChannel();
+}
+
+GracefulStop* Controller::stopServices(const QVector<MicroserviceData*> &microservices) {
+    TraceSpan span("Controller::stopServices", "command");
+    QVector<StopTarget> targets;
+
+#if !defined(Q_OS_UNIX)
+    Q_UNUSED(microservices);
+    qWarning() << "Platform not supported";
+#else
+    QSettings settings(model->getConfigFile(), QSettings::IniFormat);
+    double defaultGracePeriodSec = settings.value("NativeStop/gracePeriodSec", 10).toDouble();
+
+    ProcessTree processTree = ProcessTree::snapshot();
+    const int ownProcessGroup = static_cast<int>(::getpgrp());
+
+    // A process group or process shared by several services is signalled for the first of them only
+    QSet<int> processGroups;
+    QSet<int> pids;
+    for (auto iter = microservices.constBegin(); iter != microservices.constEnd(); ++iter) {
+        supervisor->stop((*iter)->getName());
+        recordCommandIssued(CommandRole::Stop, *iter);
+
+        StopTarget target;
+        target.serviceName = (*iter)->getName();
+        target.gracePeriodMs = static_cast<int>(settings.value("GracePeriods/" + target.serviceName, defaultGracePeriodSec).toDouble() * 1000);
+
+        QVector<int> launchedPids = processTree.getPidsInSession((*iter)->getLaunchSessionId());
+        foreach (int processGroup, processTree.getProcessGroups(launchedPids)) {
+            if (processGroup != ownProcessGroup && !processGroups.contains(processGroup)) {
+                processGroups.insert(processGroup);
+                target.processGroups.append(processGroup);
+            }
+        }
+
+        // Processes that were not started by the launcher are signalled as a group only if they lead it.
+        foreach (int pid, (*iter)->getPids(processTree)) {
+            if (launchedPids.contains(pid)) {
+                continue;
+            }
+
+            if (processTree.value(pid).processGroupId == pid && pid != ownProcessGroup) {
+                if (!processGroups.contains(pid)) {
+                    processGroups.insert(pid);
+                    target.processGroups.append(pid);
+                }
+            } else if (!pids.contains(pid)) {
+                pids.insert(pid);
+                target.pids.append(pid);
+            }
+        }
+
+        targets.append(target);
+    }
+
+    qDebug() << "Stopping" << targets.size() << "services:" << processGroups.size() << "process groups and" << pids.size() << "processes";
+#endif
+
+    GracefulStop *gracefulStop = new GracefulStop(targets, this);
+    gracefulStop->start();
+    return gracefulStop;
+}
+
 QString Controller::getCommandButtonStyle(const QString &commandName) const{
     if (!commands.contains(commandName)) {
         QMessageBox::critical(nullptr, "Error", "Command not found: " + commandName);
@@ -146,6 +943,42 @@ QStringList Controller::getCommandArgs(const QString &commandName) const{
     return commands.value(commandName)->getArgs();
 }
 
+QVector<MicroserviceStatus> Controller::getCommandRequiredStatuses(const QString &commandName) const{
+    if (!commands.contains(commandName)) {
+        QMessageBox::critical(nullptr, "Error", "Command not found: " + commandName);
+        exit(EXIT_FAILURE);
+    }
+
+    return commands.value(commandName)->getOptions().requiredStatuses;
+}
+
+bool Controller::getCommandBatch(const QString &commandName) const{
+    if (!commands.contains(commandName)) {
+        QMessageBox::critical(nullptr, "Error", "Command not found: " + commandName);
+        exit(EXIT_FAILURE);
+    }
+
+    return commands.value(commandName)->getOptions().batch;
+}
+
+PortCheck Controller::getCommandPortCheck(const QString &commandName) const{
+    if (!commands.contains(commandName)) {
+        QMessageBox::critical(nullptr, "Error", "Command not found: " + commandName);
+        exit(EXIT_FAILURE);
+    }
+
+    return commands.value(commandName)->getOptions().portCheck;
+}
+
+CommandOptions Controller::getCommandOptions(const QString &commandName) const{
+    if (!commands.contains(commandName)) {
+        QMessageBox::critical(nullptr, "Error", "Command not found: " + commandName);
+        exit(EXIT_FAILURE);
+    }
+
+    return commands.value(commandName)->getOptions();
+}
+
 bool Controller::getCommandExecuteForSelected(const QString &commandName) const{
     if (!commands.contains(commandName)) {
         QMessageBox::critical(nullptr, "Error", "Command not found: " + commandName);
@@ -159,7 +992,29 @@ QMap<QString, Command*> Controller::getCommands() const {
     return commands;
 }
 
-void Controller::addCommand(const QString &name, const QString &command, const QStringList &args, const QStringList &excludedServices, const QString buttonStyle, const bool executeForSelected, const QString &scriptName) {
+QString Controller::getCommandForRole(CommandRole role) const {
+    // [Converge] startCommand / stopCommand choose among several commands with the same role
+    if (role == CommandRole::Start || role == CommandRole::Stop) {
+        QSettings settings(model->getConfigFile(), QSettings::IniFormat);
+        settings.beginGroup("Converge");
+        QString configured = settings.value(role == CommandRole::Stop ? "stopCommand" : "startCommand").toString();
+        settings.endGroup();
+
+        if (commands.contains(configured)) {
+            return configured;
+        }
+    }
+
+    for (auto iter = commands.constBegin(); iter != commands.constEnd(); ++iter) {
+        if (iter.value()->getOptions().role == role && iter.value()->getExecuteForSelected()) {
+            return iter.key();
+        }
+    }
+
+    return QString();
+}
+
+void Controller::addCommand(const QString &name, const QString &command, const QStringList &args, const QStringList &excludedServices, const QString buttonStyle, const bool executeForSelected, const QString &scriptName, const CommandOptions &options) {
     Command *cmd = new Command(
         name,
         command,
@@ -167,11 +1022,12 @@ void Controller::addCommand(const QString &name, const QString &command, const Q
         excludedServices,
         buttonStyle,
         executeForSelected,
-        scriptName);
+        scriptName,
+        options);
     commands.insert(name, cmd);
 }
 
-void Controller::addFlag(const QString &flag, bool visible) {
+void Controller::addFlag(const QString &flag) {
     if (flag.isEmpty()) {
         return;
     }
@@ -179,7 +1035,7 @@ void Controller::addFlag(const QString &flag, bool visible) {
     QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
     QMap<QString, MicroserviceData*>::const_iterator iter;
     for (iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
-        iter.value()->addFlag(flag, visible);
+        iter.value()->addFlag(flag);
     }
 }
 
@@ -3,6 +3,15 @@
 
 #include "models/model.h"
 #include "command.h"
+#include "supervisor.h"
+#include "cgroup_manager.h"
+#include "metrics_exporter.h"
+#include "health_checker.h"
+#include "graceful_stop.h"
+#include "crash_monitor.h"
+#include "source_watcher.h"
+
+#include <functional>
 
 class Controller: public QWidget
 {
@@ -13,13 +22,27 @@ public:
     void selectAll();
     void deselectAll();
     void refresh();
+    void checkHealth();
+    void watchSources();
+    bool hasHealthEndpoint(MicroserviceData *microservice) const;
     void selectDetermined(const QString &saveName);
-    void executeScript(const QString &commandName, const QStringList &additionalArgs = QStringList());
+    QStringList getSaveServices(const QString &saveName) const;
+    void executeScript(const QString &commandName, const QStringList &additionalArgs = QStringList(), MicroserviceData *microservice = nullptr);
+    void executeScriptAsync(const QString &commandName, const QStringList &additionalArgs, MicroserviceData *microservice, const std::function<void(int exitCode)> &onFinished);
+    void executeBuildAsync(const QString &commandName, const QStringList &additionalArgs, MicroserviceData *microservice, int jobs, const std::function<void(int exitCode)> &onFinished);
+    void executeBatchScript(const QString &commandName, const QVector<MicroserviceData*> &microservices, const QStringList &commandArgs, const std::function<void(const QMap<QString, int> &results)> &onFinished);
+    GracefulStop* stopServices(const QVector<MicroserviceData*> &microservices);
+    bool isSupervised(const QString &serviceName) const;
     QString getCommandButtonStyle(const QString &commandName) const;
     bool getCommandExecuteForSelected(const QString &commandName) const;
+    bool getCommandBatch(const QString &commandName) const;
+    PortCheck getCommandPortCheck(const QString &commandName) const;
+    CommandOptions getCommandOptions(const QString &commandName) const;
     QStringList getCommandExcludedServices(const QString &commandName) const;
     QStringList getCommandArgs(const QString &commandName) const;
+    QVector<MicroserviceStatus> getCommandRequiredStatuses(const QString &commandName) const;
     QMap<QString, Command*> getCommands() const;
+    QString getCommandForRole(CommandRole role) const;
     void addCommand(
         const QString &name,
         const QString &command,
@@ -27,15 +50,39 @@ public:
         const QStringList &excludedServices,
         const QString buttonStyle,
         const bool executeForSelected,
-        const QString &scriptName);
-    void addFlag(const QString &flag, bool visible);
+        const QString &scriptName,
+        const CommandOptions &options = CommandOptions());
+    void addFlag(const QString &flag);
     void updateFlagStateForAllServices(const QString &flag, Qt::CheckState);
 
+signals:
+    void microserviceStateChanged(const QString &serviceName);
+    void microserviceCrashed(const QString &serviceName, const QString &message, bool circuitOpen);
+    void sourcesChanged(const QString &serviceName, const QString &commandName, const QStringList &commandArgs);
+
 private:
     Model* model;
 
     void loadCommandsFromConfig();
+    std::function<void()> createChildProcessModifier(MicroserviceData *microservice, bool joinCgroup);
+    void updateResourceUsage(MicroserviceData *microservice) const;
+    void applyHealthResult(const QString &serviceName, const HealthResult &result);
+    void detectCrashes();
+    void restartCrashedService(const QString &serviceName, const QString &commandName, const QStringList &arguments);
+    void applyCrash(const QString &serviceName, const QString &message, bool circuitOpen);
+    void applySourceChange(const QString &serviceName, const QString &commandName, const QStringList &commandArgs);
+    void beginCommand(const QString &serviceName);
+    void endCommand(const QString &serviceName);
+    void recordCommandIssued(CommandRole role, MicroserviceData *microservice, const QString &commandName = QString(), const QStringList &additionalArgs = QStringList()) const;
+    void recordCommandMetrics(const QString &commandName, const QString &serviceName, int exitCode, qint64 elapsedMs) const;
     QMap<QString, Command*> commands;
+    Supervisor *supervisor;
+    CgroupManager cgroupManager;
+    MetricsExporter *metricsExporter;
+    HealthChecker *healthChecker;
+    CrashMonitor *crashMonitor;
+    SourceWatcher *sourceWatcher;
+    QHash<QString, int> commandsInProgress;
 };
 
 #endif // CONTROLLER_H
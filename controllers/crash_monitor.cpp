@@ -0,0 +1,122 @@
+#include "crash_monitor.h"
+#include "models/microservice_data.h"
+#include "utils/metrics.h"
+#include "utils/output_log.h"
+
+#include <QDir>
+#include <QSettings>
+
+CrashMonitor::CrashMonitor(const QString &configFile, QObject *parent)
+    : QObject(parent)
+    , intervalTimer(new QTimer(this))
+{
+    QSettings settings(configFile, QSettings::IniFormat);
+    settings.beginGroup("CrashDetection");
+    int intervalSec = settings.value("intervalSec", 5).toInt();
+    logFile = settings.value("logFile").toString();
+    lastLineCount = settings.value("lastLines", 20).toInt();
+    settings.endGroup();
+
+    // An interval of 0 limits crash detection to manual refreshes
+    if (intervalSec > 0) {
+        intervalTimer->setInterval(intervalSec * 1000);
+        connect(intervalTimer, &QTimer::timeout, this, &CrashMonitor::checkRequested);
+        intervalTimer->start();
+    }
+}
+
+void CrashMonitor::recordStart(const QString &serviceName, const QString &commandName, const QStringList &arguments, const SupervisionPolicy &policy, bool autoRestart) {
+    StartedService &service = services[serviceName];
+
+    // A start by hand closes the circuit again, a restart issued here keeps counting
+    if (!service.restarting) {
+        service.backoff = RestartBackoff(policy.restartDelayMs, policy.maxRestartDelayMs, policy.crashLoopLimit, policy.crashLoopWindowSec);
+    }
+
+    if (service.restartTimer) {
+        service.restartTimer->stop();
+    }
+
+    service.commandName = commandName;
+    service.arguments = arguments;
+    service.autoRestart = autoRestart;
+    service.stopped = false;
+    service.restarting = false;
+    service.uptime.start();
+}
+
+void CrashMonitor::recordStop(const QString &serviceName) {
+    if (!services.contains(serviceName)) {
+        return;
+    }
+
+    StartedService &service = services[serviceName];
+    service.stopped = true;
+    service.restarting = false;
+    if (service.restartTimer) {
+        service.restartTimer->stop();
+    }
+}
+
+bool CrashMonitor::isWatched(const QString &serviceName) const {
+    // Services started outside the launcher were never recorded, so they are not reported
+    return services.contains(serviceName) && !services.value(serviceName).stopped;
+}
+
+void CrashMonitor::serviceExited(MicroserviceData *microservice) {
+    const QString serviceName = microservice->getName();
+    if (!isWatched(serviceName)) {
+        return;
+    }
+
+    Metrics::instance().increment("launcher_crashes_total", {{"service", serviceName}});
+    qWarning() << "Service" << serviceName << "went down without a stop command";
+
+    StartedService &service = services[serviceName];
+    if (!service.autoRestart || service.commandName.isEmpty()) {
+        service.stopped = true;
+        emit crashed(serviceName, "exited unexpectedly", false);
+        return;
+    }
+
+    const int delayMs = service.backoff.nextDelay(service.uptime.isValid() ? service.uptime.elapsed() : 0);
+    if (delayMs < 0) {
+        service.stopped = true;
+        qWarning() << "Service" << serviceName << "is crash looping, restarts stopped";
+        emit crashed(serviceName, QString("crash loop: %1 crashes within %2 min, restarts stopped")
+            .arg(service.backoff.getRecentFailures())
+            .arg(service.backoff.getCrashLoopWindowSec() / 60.0, 0, 'g', 3), true);
+        return;
+    }
+
+    if (!service.restartTimer) {
+        service.restartTimer = new QTimer(this);
+        service.restartTimer->setSingleShot(true);
+        connect(service.restartTimer, &QTimer::timeout, this, [this, serviceName]() {
+            StartedService &restarted = services[serviceName];
+            if (restarted.stopped) {
+                return;
+            }
+
+            restarted.restarting = true;
+            emit restartRequested(serviceName, restarted.commandName, restarted.arguments);
+        });
+    }
+
+    qDebug() << "Restarting" << serviceName << "in" << delayMs << "ms";
+    service.restartTimer->start(delayMs);
+    emit crashed(serviceName, QString("crashed, restarting in %1 s").arg(delayMs / 1000.0, 0, 'g', 3), false);
+}
+
+QStringList CrashMonitor::getLastLines(MicroserviceData *microservice) const {
+    // The service's own log file tells more than the output of its start script, when there is one
+    if (!logFile.isEmpty()) {
+        QDir folder(QDir(microservice->getDirectory()).filePath(microservice->getFolderName()));
+        QStringList lines = OutputLog::readLastLines(folder.filePath(logFile), lastLineCount);
+        if (!lines.isEmpty()) {
+            return lines;
+        }
+    }
+
+    return OutputLog::instance().getLastLines(microservice->getName(), lastLineCount);
+}
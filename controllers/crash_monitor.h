@@ -0,0 +1,53 @@
+#ifndef CRASH_MONITOR_H
+#define CRASH_MONITOR_H
+
+#include "restart_backoff.h"
+#include "supervisor.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+class MicroserviceData;
+
+// Tells services that went down on their own from services stopped by the launcher, and restarts
+// services whose start command allows it with an exponential delay. A service that keeps crashing
+// trips its circuit breaker and stays down until it is started again by hand.
+class CrashMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CrashMonitor(const QString &configFile, QObject *parent = nullptr);
+
+    void recordStart(const QString &serviceName, const QString &commandName, const QStringList &arguments, const SupervisionPolicy &policy, bool autoRestart);
+    void recordStop(const QString &serviceName);
+    bool isWatched(const QString &serviceName) const;
+    void serviceExited(MicroserviceData *microservice);
+    QStringList getLastLines(MicroserviceData *microservice) const;
+
+signals:
+    void checkRequested();
+    void restartRequested(const QString &serviceName, const QString &commandName, const QStringList &arguments);
+    void crashed(const QString &serviceName, const QString &message, bool circuitOpen);
+
+private:
+    struct StartedService {
+        QString commandName;
+        QStringList arguments;
+        bool autoRestart = false;
+        bool stopped = false;
+        bool restarting = false;
+        RestartBackoff backoff;
+        QElapsedTimer uptime;
+        QTimer *restartTimer = nullptr;
+    };
+
+    QHash<QString, StartedService> services;
+    QTimer *intervalTimer;
+    QString logFile;
+    int lastLineCount;
+};
+
+#endif // CRASH_MONITOR_H
@@ -0,0 +1,169 @@
+#include "graceful_stop.h"
+#include "utils/tracer.h"
+#include "utils/metrics.h"
+
+#include <QFile>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#endif
+
+namespace {
+const int pollIntervalMs = 100;
+const int killTimeoutMs = 5000; // after SIGKILL, only processes stuck in the kernel remain
+}
+
+GracefulStop::GracefulStop(const QVector<StopTarget> &targets, QObject *parent)
+    : QObject(parent)
+    , pollTimer(new QTimer(this))
+{
+    for (auto iter = targets.constBegin(); iter != targets.constEnd(); ++iter) {
+        TargetState state;
+        state.target = *iter;
+        states.append(state);
+    }
+
+    pollTimer->setInterval(pollIntervalMs);
+    connect(pollTimer, &QTimer::timeout, this, &GracefulStop::poll);
+}
+
+void GracefulStop::start() {
+    TraceSpan span("GracefulStop::start", "command");
+    elapsed.start();
+
+#if defined(Q_OS_UNIX)
+    for (auto iter = states.constBegin(); iter != states.constEnd(); ++iter) {
+        sendSignal(iter->target, SIGTERM);
+    }
+#endif
+
+    qDebug() << "Sent SIGTERM to" << states.size() << "services";
+
+    // The first poll is queued, so finished() is never emitted before the caller connected to it
+    pollTimer->start();
+    QTimer::singleShot(0, this, &GracefulStop::poll);
+}
+
+void GracefulStop::poll() {
+    if (!pollTimer->isActive()) {
+        return;
+    }
+
+    bool pending = false;
+    for (auto iter = states.begin(); iter != states.end(); ++iter) {
+        if (iter->done) {
+            continue;
+        }
+
+        const QString &serviceName = iter->target.serviceName;
+        if (!isAlive(iter->target)) {
+            iter->done = true;
+            (iter->killed ? forced : stopped).append(serviceName);
+            Metrics::instance().observe("launcher_stop_duration_seconds", {{"service", serviceName}}, elapsed.elapsed() / 1000.0);
+            continue;
+        }
+
+        pending = true;
+        if (!iter->killed && elapsed.elapsed() >= iter->target.gracePeriodMs) {
+            qWarning() << serviceName << "did not exit within" << iter->target.gracePeriodMs << "ms, sending SIGKILL";
+#if defined(Q_OS_UNIX)
+            sendSignal(iter->target, SIGKILL);
+#endif
+            iter->killed = true;
+            iter->killedAtMs = elapsed.elapsed();
+            Metrics::instance().increment("launcher_forced_stops_total", {{"service", serviceName}});
+        } else if (iter->killed && elapsed.elapsed() - iter->killedAtMs >= killTimeoutMs) {
+            qWarning() << serviceName << "is still running after SIGKILL";
+            iter->done = true;
+            survivors.append(serviceName);
+        }
+    }
+
+    if (!pending) {
+        pollTimer->stop();
+        qDebug() << "Stopped" << stopped.size() << "services, forced" << forced.size() << ", still running" << survivors.size()
+                 << "in" << elapsed.elapsed() << "ms";
+        emit finished();
+        deleteLater();
+    }
+}
+
+bool GracefulStop::isAlive(const StopTarget &target) {
+#if defined(Q_OS_UNIX)
+    // A process group exists as long as one of its members does
+    for (int processGroup : target.processGroups) {
+        if (::kill(-processGroup, 0) == 0 || errno == EPERM) {
+            return true;
+        }
+    }
+
+    for (int pid : target.pids) {
+        if (isProcessAlive(pid)) {
+            return true;
+        }
+    }
+#else
+    Q_UNUSED(target);
+#endif
+
+    return false;
+}
+
+bool GracefulStop::isProcessAlive(int pid) {
+#if defined(Q_OS_UNIX)
+    if (::kill(pid, 0) != 0 && errno != EPERM) {
+        return false;
+    }
+
+    #if defined(Q_OS_LINUX)
+        // A zombie has exited already, it only waits for its parent
+        QFile statFile(QString("/proc/%1/stat").arg(pid));
+        if (statFile.open(QIODevice::ReadOnly)) {
+            QByteArray stat = statFile.readAll();
+            int commandEnd = stat.lastIndexOf(')');
+            if (commandEnd != -1 && stat.mid(commandEnd + 2, 1) == "Z") {
+                return false;
+            }
+        }
+    #endif
+
+    return true;
+#else
+    Q_UNUSED(pid);
+    return false;
+#endif
+}
+
+void GracefulStop::sendSignal(const StopTarget &target, int signal) {
+#if defined(Q_OS_UNIX)
+    for (int processGroup : target.processGroups) {
+        if (::kill(-processGroup, signal) != 0 && errno != ESRCH) {
+            qWarning() << "Failed to signal process group" << processGroup << ":" << strerror(errno);
+        }
+    }
+
+    for (int pid : target.pids) {
+        if (::kill(pid, signal) != 0 && errno != ESRCH) {
+            qWarning() << "Failed to signal process" << pid << ":" << strerror(errno);
+        }
+    }
+#else
+    Q_UNUSED(target);
+    Q_UNUSED(signal);
+#endif
+}
+
+QStringList GracefulStop::getStopped() const {
+    return stopped;
+}
+
+QStringList GracefulStop::getForced() const {
+    return forced;
+}
+
+QStringList GracefulStop::getSurvivors() const {
+    return survivors;
+}
@@ -0,0 +1,56 @@
+#ifndef GRACEFUL_STOP_H
+#define GRACEFUL_STOP_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+// Everything that has to exit for a service to be stopped
+struct StopTarget {
+    QString serviceName;
+    QVector<int> processGroups;
+    QVector<int> pids;
+    int gracePeriodMs = 10000;
+};
+
+// Sends SIGTERM to all targets at once and waits for all of them concurrently; a target
+// that is still alive after its grace period gets SIGKILL. The whole stop takes as long
+// as the slowest service. Deletes itself after finished() was emitted.
+class GracefulStop : public QObject
+{
+    Q_OBJECT
+public:
+    explicit GracefulStop(const QVector<StopTarget> &targets, QObject *parent = nullptr);
+
+    void start();
+    QStringList getStopped() const;
+    QStringList getForced() const;
+    QStringList getSurvivors() const;
+
+signals:
+    void finished();
+
+private:
+    struct TargetState {
+        StopTarget target;
+        bool killed = false;
+        qint64 killedAtMs = 0;
+        bool done = false;
+    };
+
+    void poll();
+    static bool isAlive(const StopTarget &target);
+    static bool isProcessAlive(int pid);
+    static void sendSignal(const StopTarget &target, int signal);
+
+    QVector<TargetState> states;
+    QStringList stopped;
+    QStringList forced;
+    QStringList survivors;
+    QElapsedTimer elapsed;
+    QTimer *pollTimer;
+};
+
+#endif // GRACEFUL_STOP_H
@@ -0,0 +1,419 @@
+#include "health_checker.h"
+#include "utils/tracer.h"
+
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSettings>
+
+namespace {
+const int maxHeaderSize = 16384;
+const int maxBodySize = 1024 * 1024;
+}
+
+HealthChecker::HealthChecker(const QString &configFile, QObject *parent)
+    : QObject(parent)
+    , intervalTimer(new QTimer(this))
+    , timeoutTimer(new QTimer(this))
+{
+    QSettings settings(configFile, QSettings::IniFormat);
+    settings.beginGroup("Health");
+    int intervalSec = settings.value("intervalSec", 10).toInt();
+    timeoutMs = settings.value("timeoutMs", 2000).toInt();
+    degradedMs = settings.value("degradedMs", 1000).toInt();
+    defaultPath = settings.value("path", "/health").toString().toUtf8();
+    settings.endGroup();
+
+    settings.beginGroup("HealthEndpoints");
+    foreach (const QString &serviceName, settings.childKeys()) {
+        endpointOverrides.insert(serviceName, settings.value(serviceName).toString());
+    }
+    settings.endGroup();
+
+    // An interval of 0 limits checks to manual refreshes
+    if (intervalSec > 0) {
+        intervalTimer->setInterval(intervalSec * 1000);
+        connect(intervalTimer, &QTimer::timeout, this, &HealthChecker::checkRequested);
+        intervalTimer->start();
+    }
+
+    timeoutTimer->setInterval(qBound(50, timeoutMs / 4, 500));
+    connect(timeoutTimer, &QTimer::timeout, this, &HealthChecker::checkTimeouts);
+}
+
+HealthChecker::~HealthChecker() {
+    for (auto iter = connections.constBegin(); iter != connections.constEnd(); ++iter) {
+        iter.value()->socket->disconnect(this);
+        delete iter.value();
+    }
+}
+
+HealthTarget HealthChecker::getTarget(const QString &serviceName, const QString &declaredEndpoint) const {
+    HealthTarget target;
+    target.serviceName = serviceName;
+
+    // Endpoints are written as <port><path>, e.g. 8080/actuator/health; the path defaults to [Health] path
+    QString endpoint = endpointOverrides.value(serviceName, declaredEndpoint).trimmed();
+    int slash = endpoint.indexOf('/');
+    target.port = endpoint.left(slash).toInt();
+    target.path = slash != -1 ? endpoint.mid(slash).toUtf8() : defaultPath;
+    return target;
+}
+
+void HealthChecker::check(const QVector<HealthTarget> &targets) {
+    TraceSpan span("HealthChecker::check", "health");
+    for (auto iter = targets.constBegin(); iter != targets.constEnd(); ++iter) {
+        // A service whose previous check is still outstanding is not asked again
+        if (iter->port <= 0 || inProgress.contains(iter->serviceName)) {
+            continue;
+        }
+
+        Request request;
+        request.target = *iter;
+        request.timer.start();
+        inProgress.insert(iter->serviceName);
+        enqueue(request);
+    }
+}
+
+HealthChecker::Connection* HealthChecker::getConnection(int port) {
+    Connection *connection = connections.value(port);
+    if (connection) {
+        return connection;
+    }
+
+    connection = new Connection;
+    connection->socket = new QTcpSocket(this);
+    QTcpSocket *socket = connection->socket;
+    connect(socket, &QTcpSocket::connected, this, [this, port]() {
+        writePending(connections.value(port));
+    });
+    connect(socket, &QTcpSocket::readyRead, this, [this, port]() {
+        onReadyRead(port);
+    });
+    connect(socket, &QTcpSocket::disconnected, this, [this, port, socket]() {
+        onConnectionClosed(port, socket);
+    });
+    connect(socket, &QTcpSocket::errorOccurred, this, [this, port, socket]() {
+        onConnectionClosed(port, socket);
+    });
+
+    connections.insert(port, connection);
+    return connection;
+}
+
+void HealthChecker::enqueue(const Request &request) {
+    Connection *connection = getConnection(request.target.port);
+    connection->pending.enqueue(request);
+
+    if (connection->socket->state() == QAbstractSocket::ConnectedState) {
+        writePending(connection);
+    } else if (connection->socket->state() == QAbstractSocket::UnconnectedState) {
+        connection->socket->connectToHost(QHostAddress(QHostAddress::LocalHost), static_cast<quint16>(request.target.port));
+    }
+
+    if (!timeoutTimer->isActive()) {
+        timeoutTimer->start();
+    }
+}
+
+void HealthChecker::writePending(Connection *connection) {
+    if (!connection) {
+        return;
+    }
+
+    // Requests are written back to back without waiting for the previous response
+    QByteArray requests;
+    while (!connection->pending.isEmpty()) {
+        Request request = connection->pending.dequeue();
+        requests += "GET " + request.target.path + " HTTP/1.1\r\n"
+            "Host: 127.0.0.1:" + QByteArray::number(request.target.port) + "\r\n"
+            "User-Agent: microservice-launcher/" APP_VERSION "\r\n"
+            "Accept: application/json, */*\r\n"
+            "Connection: keep-alive\r\n\r\n";
+        connection->inFlight.enqueue(request);
+    }
+
+    if (!requests.isEmpty()) {
+        connection->socket->write(requests);
+    }
+}
+
+void HealthChecker::onReadyRead(int port) {
+    Connection *connection = connections.value(port);
+    if (!connection) {
+        return;
+    }
+
+    connection->buffer += connection->socket->readAll();
+
+    while (!connection->inFlight.isEmpty()) {
+        Response response;
+        int consumed = parseResponse(connection->buffer, false, response);
+        if (consumed == 0) {
+            return;
+        }
+
+        if (consumed < 0) {
+            closeConnection(port, false, "Malformed HTTP response");
+            return;
+        }
+
+        connection->buffer.remove(0, consumed);
+
+        // Interim responses (100 Continue) precede the real one
+        if (response.status >= 100 && response.status < 200) {
+            continue;
+        }
+
+        finish(connection->inFlight.dequeue(), response);
+
+        if (response.close) {
+            closeConnection(port, true, "Connection closed by the service");
+            return;
+        }
+    }
+}
+
+void HealthChecker::onConnectionClosed(int port, QTcpSocket *socket) {
+    Connection *connection = connections.value(port);
+    if (!connection || connection->socket != socket) {
+        return;
+    }
+
+    // A response without length or chunked encoding ends with the connection
+    connection->buffer += socket->readAll();
+    if (!connection->inFlight.isEmpty() && !connection->buffer.isEmpty()) {
+        Response response;
+        if (parseResponse(connection->buffer, true, response) > 0) {
+            finish(connection->inFlight.dequeue(), response);
+        }
+    }
+
+    // Refused or timed out connections are final; a keep-alive connection closed by the service is retried once
+    QAbstractSocket::SocketError error = socket->error();
+    bool retry = error != QAbstractSocket::ConnectionRefusedError && error != QAbstractSocket::SocketTimeoutError;
+    closeConnection(port, retry, socket->errorString());
+}
+
+void HealthChecker::closeConnection(int port, bool retry, const QString &error) {
+    Connection *connection = connections.take(port);
+    if (!connection) {
+        return;
+    }
+
+    connection->socket->disconnect(this);
+    connection->socket->abort();
+    connection->socket->deleteLater();
+
+    QList<Request> unanswered = connection->inFlight;
+    unanswered += connection->pending;
+    delete connection;
+
+    for (auto iter = unanswered.begin(); iter != unanswered.end(); ++iter) {
+        Request &request = *iter;
+        if (retry && !request.retried) {
+            request.retried = true;
+            enqueue(request);
+        } else {
+            fail(request, error);
+        }
+    }
+}
+
+void HealthChecker::checkTimeouts() {
+    QList<int> expiredPorts;
+    for (auto iter = connections.constBegin(); iter != connections.constEnd(); ++iter) {
+        const Connection *connection = iter.value();
+        const QQueue<Request> &oldest = connection->inFlight.isEmpty() ? connection->pending : connection->inFlight;
+        if (!oldest.isEmpty() && oldest.head().timer.elapsed() > timeoutMs) {
+            expiredPorts.append(iter.key());
+        }
+    }
+
+    foreach (int port, expiredPorts) {
+        closeConnection(port, false, QString("No response within %1 ms").arg(timeoutMs));
+    }
+
+    if (inProgress.isEmpty()) {
+        timeoutTimer->stop();
+    }
+}
+
+void HealthChecker::finish(const Request &request, const Response &response) {
+    const QString &serviceName = request.target.serviceName;
+    qint64 latencyUs = request.timer.nsecsElapsed() / 1000;
+
+    LatencyHistogram &histogram = histograms[serviceName];
+    histogram.record(latencyUs);
+
+    HealthResult result;
+    result.httpStatus = response.status;
+    result.latencyUs = latencyUs;
+    result.state = classify(response, latencyUs, result.bodyStatus);
+    result.p50Us = histogram.valueAtPercentile(50);
+    result.p99Us = histogram.valueAtPercentile(99);
+    result.samples = histogram.getCount();
+
+    inProgress.remove(serviceName);
+    emit healthChecked(serviceName, result);
+}
+
+void HealthChecker::fail(const Request &request, const QString &error) {
+    const QString &serviceName = request.target.serviceName;
+    const LatencyHistogram &histogram = histograms[serviceName];
+
+    HealthResult result;
+    result.state = HealthState::Down;
+    result.error = error;
+    result.p50Us = histogram.valueAtPercentile(50);
+    result.p99Us = histogram.valueAtPercentile(99);
+    result.samples = histogram.getCount();
+
+    inProgress.remove(serviceName);
+    emit healthChecked(serviceName, result);
+}
+
+HealthState HealthChecker::classify(const Response &response, qint64 latencyUs, QString &bodyStatus) const {
+    // Spring Boot style {"status": "UP"} or health+json style {"status": "pass"} bodies refine the HTTP status
+    QJsonObject body = QJsonDocument::fromJson(response.body).object();
+    bodyStatus = body.value("status").toString();
+    QString status = bodyStatus.toUpper();
+
+    if (response.status >= 500 || status == "DOWN" || status == "FAIL") {
+        return HealthState::Down;
+    }
+
+    if (response.status < 200 || response.status >= 300) {
+        return HealthState::Degraded;
+    }
+
+    if (!status.isEmpty() && status != "UP" && status != "PASS" && status != "OK") {
+        return HealthState::Degraded;
+    }
+
+    return latencyUs > degradedMs * 1000LL ? HealthState::Degraded : HealthState::Healthy;
+}
+
+int HealthChecker::parseResponse(const QByteArray &buffer, bool atEnd, Response &response) {
+    // Returns the size of the complete response at the start of buffer, 0 if it is incomplete, -1 if it is malformed
+    int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd == -1) {
+        return buffer.size() > maxHeaderSize ? -1 : 0;
+    }
+
+    QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    QList<QByteArray> statusLine = lines.value(0).trimmed().split(' ');
+    if (!statusLine.value(0).startsWith("HTTP/1.")) {
+        return -1;
+    }
+
+    bool ok;
+    response.status = statusLine.value(1).toInt(&ok);
+    if (!ok) {
+        return -1;
+    }
+
+    response.close = statusLine.value(0) == "HTTP/1.0";
+    qint64 contentLength = -1;
+    bool chunked = false;
+    for (int i = 1; i < lines.size(); ++i) {
+        int colon = lines.at(i).indexOf(':');
+        QByteArray name = lines.at(i).left(colon).trimmed().toLower();
+        QByteArray value = lines.at(i).mid(colon + 1).trimmed().toLower();
+
+        if (name == "content-length") {
+            contentLength = value.toLongLong();
+        } else if (name == "transfer-encoding") {
+            chunked = value.contains("chunked");
+        } else if (name == "connection") {
+            response.close = value.contains("close") ? true : (value.contains("keep-alive") ? false : response.close);
+        }
+    }
+
+    int bodyStart = headerEnd + 4;
+    if ((response.status >= 100 && response.status < 200) || response.status == 204 || response.status == 304) {
+        return bodyStart;
+    }
+
+    if (chunked) {
+        int pos = bodyStart;
+        while (true) {
+            int lineEnd = buffer.indexOf("\r\n", pos);
+            if (lineEnd == -1) {
+                return 0;
+            }
+
+            int chunkSize = buffer.mid(pos, lineEnd - pos).split(';').value(0).trimmed().toInt(&ok, 16);
+            if (!ok || chunkSize < 0 || response.body.size() + chunkSize > maxBodySize) {
+                return -1;
+            }
+
+            pos = lineEnd + 2;
+            if (chunkSize == 0) {
+                // The last chunk may be followed by trailers, which end with an empty line
+                if (buffer.mid(pos, 2) == "\r\n") {
+                    return pos + 2;
+                }
+
+                int trailerEnd = buffer.indexOf("\r\n\r\n", pos);
+                return trailerEnd == -1 ? 0 : trailerEnd + 4;
+            }
+
+            if (buffer.size() < pos + chunkSize + 2) {
+                return 0;
+            }
+
+            response.body += buffer.mid(pos, chunkSize);
+            pos += chunkSize + 2;
+        }
+    }
+
+    if (contentLength >= 0) {
+        if (contentLength > maxBodySize) {
+            return -1;
+        }
+
+        if (buffer.size() < bodyStart + contentLength) {
+            return 0;
+        }
+
+        response.body = buffer.mid(bodyStart, static_cast<int>(contentLength));
+        return bodyStart + static_cast<int>(contentLength);
+    }
+
+    // Without a length the body ends with the connection
+    response.close = true;
+    if (!atEnd) {
+        return 0;
+    }
+
+    response.body = buffer.mid(bodyStart);
+    return buffer.size();
+}
+
+QString HealthChecker::describe(const HealthResult &result) {
+    if (result.state == HealthState::Unknown) {
+        return QString();
+    }
+
+    QString text = healthStateToString(result.state) + ": ";
+    if (result.httpStatus > 0) {
+        text += "HTTP " + QString::number(result.httpStatus);
+        if (!result.bodyStatus.isEmpty()) {
+            text += " (" + result.bodyStatus + ")";
+        }
+        text += QString(" in %1 ms").arg(result.latencyUs / 1000.0, 0, 'f', 1);
+    } else {
+        text += result.error;
+    }
+
+    if (result.samples > 0) {
+        text += QString("\nLatency p50 %1 ms, p99 %2 ms over %3 responses")
+            .arg(result.p50Us / 1000.0, 0, 'f', 1)
+            .arg(result.p99Us / 1000.0, 0, 'f', 1)
+            .arg(result.samples);
+    }
+
+    return text;
+}
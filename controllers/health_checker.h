@@ -0,0 +1,94 @@
+#ifndef HEALTH_CHECKER_H
+#define HEALTH_CHECKER_H
+
+#include "models/microservice_status.h"
+#include "utils/latency_histogram.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QTcpSocket>
+#include <QTimer>
+
+struct HealthTarget {
+    QString serviceName;
+    int port = 0;
+    QByteArray path;
+};
+
+struct HealthResult {
+    HealthState state = HealthState::Unknown;
+    int httpStatus = 0;
+    QString bodyStatus;
+    qint64 latencyUs = -1;
+    QString error;
+    qint64 p50Us = -1;
+    qint64 p99Us = -1;
+    quint64 samples = 0;
+};
+
+// Checks the HTTP health endpoints of running services on the loopback interface.
+// One keep-alive connection is kept per port and all requests for that port are
+// pipelined on it, so a round of checks costs no new connections once they are open.
+class HealthChecker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HealthChecker(const QString &configFile, QObject *parent = nullptr);
+    ~HealthChecker();
+
+    HealthTarget getTarget(const QString &serviceName, const QString &declaredEndpoint) const;
+    void check(const QVector<HealthTarget> &targets);
+
+    static QString describe(const HealthResult &result);
+
+signals:
+    void checkRequested();
+    void healthChecked(const QString &serviceName, const HealthResult &result);
+
+private:
+    struct Request {
+        HealthTarget target;
+        QElapsedTimer timer;
+        bool retried = false;
+    };
+
+    struct Response {
+        int status = 0;
+        QByteArray body;
+        bool close = false;
+    };
+
+    struct Connection {
+        QTcpSocket *socket = nullptr;
+        QQueue<Request> pending;  // waiting for the connection to be established
+        QQueue<Request> inFlight; // written, answered in order
+        QByteArray buffer;
+    };
+
+    Connection* getConnection(int port);
+    void enqueue(const Request &request);
+    void writePending(Connection *connection);
+    void onReadyRead(int port);
+    void onConnectionClosed(int port, QTcpSocket *socket);
+    void closeConnection(int port, bool retry, const QString &error);
+    void checkTimeouts();
+    void finish(const Request &request, const Response &response);
+    void fail(const Request &request, const QString &error);
+    HealthState classify(const Response &response, qint64 latencyUs, QString &bodyStatus) const;
+    static int parseResponse(const QByteArray &buffer, bool atEnd, Response &response);
+
+    QHash<int, Connection*> connections;
+    QSet<QString> inProgress;
+    QHash<QString, LatencyHistogram> histograms;
+    QHash<QString, QString> endpointOverrides;
+    QByteArray defaultPath;
+    int timeoutMs;
+    int degradedMs;
+    QTimer *intervalTimer;
+    QTimer *timeoutTimer;
+};
+
+#endif // HEALTH_CHECKER_H
@@ -0,0 +1,120 @@
+#include "metrics_exporter.h"
+#include "utils/metrics.h"
+
+#include <QSaveFile>
+#include <QSettings>
+
+namespace {
+const int maxRequestSize = 8192;
+}
+
+MetricsExporter::MetricsExporter(const QString &configFile, QObject *parent)
+    : QObject(parent)
+    , server(nullptr)
+    , fileTimer(nullptr)
+{
+    QSettings settings(configFile, QSettings::IniFormat);
+    settings.beginGroup("Metrics");
+
+    int port = settings.value("port", 0).toInt();
+    QString address = settings.value("address", "127.0.0.1").toString();
+    fileName = settings.value("file").toString();
+    int intervalSec = settings.value("intervalSec", 15).toInt();
+
+    settings.endGroup();
+
+    if (port > 0) {
+        server = new QTcpServer(this);
+        connect(server, &QTcpServer::newConnection, this, &MetricsExporter::onNewConnection);
+
+        if (server->listen(QHostAddress(address), static_cast<quint16>(port))) {
+            qDebug() << "Serving metrics on" << address + ":" + QString::number(port) + "/metrics";
+        } else {
+            qWarning() << "Failed to listen for metrics on" << address << port << ":" << server->errorString();
+        }
+    }
+
+    if (!fileName.isEmpty()) {
+        fileTimer = new QTimer(this);
+        fileTimer->setInterval(qMax(1, intervalSec) * 1000);
+        connect(fileTimer, &QTimer::timeout, this, &MetricsExporter::writeFile);
+        fileTimer->start();
+    }
+}
+
+MetricsExporter::~MetricsExporter() {
+    // The file keeps the last values after the launcher exits
+    if (fileTimer) {
+        writeFile();
+    }
+}
+
+void MetricsExporter::onNewConnection() {
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            onReadyRead(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            requests.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MetricsExporter::onReadyRead(QTcpSocket *socket) {
+    QByteArray &request = requests[socket];
+    request += socket->readAll();
+
+    if (!request.contains("\r\n\r\n") && !request.contains("\n\n")) {
+        if (request.size() > maxRequestSize) {
+            socket->abort();
+        }
+        return;
+    }
+
+    QList<QByteArray> requestLine = request.left(request.indexOf('\n')).trimmed().split(' ');
+    QByteArray method = requestLine.value(0);
+    QByteArray path = requestLine.value(1);
+
+    QByteArray status = "200 OK";
+    QByteArray contentType = "text/plain; version=0.0.4; charset=utf-8";
+    QByteArray body;
+
+    if (method != "GET" && method != "HEAD") {
+        status = "405 Method Not Allowed";
+        contentType = "text/plain";
+    } else if (path != "/metrics" && !path.startsWith("/metrics?")) {
+        status = "404 Not Found";
+        contentType = "text/plain";
+        body = "Metrics are served on /metrics\n";
+    } else {
+        body = Metrics::instance().render();
+    }
+
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+        "Content-Type: " + contentType + "\r\n"
+        "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n";
+    if (method != "HEAD") {
+        response += body;
+    }
+
+    requests.remove(socket);
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+void MetricsExporter::writeFile() const {
+    // QSaveFile renames the complete file into place, so a collector never reads a partial file
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write metrics file" << fileName << ":" << file.errorString();
+        return;
+    }
+
+    file.write(Metrics::instance().render());
+    if (!file.commit()) {
+        qWarning() << "Failed to write metrics file" << fileName << ":" << file.errorString();
+    }
+}
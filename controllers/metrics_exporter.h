@@ -0,0 +1,30 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <QHash>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+// Serves the launcher metrics on a local HTTP endpoint and/or rewrites them
+// periodically into a .prom file, as configured in the [Metrics] section.
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsExporter(const QString &configFile, QObject *parent = nullptr);
+    ~MetricsExporter();
+
+private:
+    void onNewConnection();
+    void onReadyRead(QTcpSocket *socket);
+    void writeFile() const;
+
+    QTcpServer *server;
+    QTimer *fileTimer;
+    QString fileName;
+    QHash<QTcpSocket*, QByteArray> requests;
+};
+
+#endif // METRICS_EXPORTER_H
@@ -0,0 +1,58 @@
+#include "restart_backoff.h"
+
+#include <QDateTime>
+
+RestartBackoff::RestartBackoff(int initialDelayMs, int maxDelayMs, int crashLoopLimit, int crashLoopWindowSec)
+    : initialDelayMs(initialDelayMs)
+    , maxDelayMs(maxDelayMs)
+    , crashLoopLimit(crashLoopLimit)
+    , crashLoopWindowSec(crashLoopWindowSec)
+    , delayMs(initialDelayMs)
+    , tripped(false)
+{}
+
+void RestartBackoff::reset() {
+    delayMs = initialDelayMs;
+    failureTimestamps.clear();
+    tripped = false;
+}
+
+// Records a failure after the given uptime and returns the delay before the next restart, or -1 if the breaker tripped
+int RestartBackoff::nextDelay(qint64 uptimeMs) {
+    if (tripped) {
+        return -1;
+    }
+
+    // A service that stayed up for a whole crash loop window starts over with the initial delay.
+    const qint64 windowMs = static_cast<qint64>(crashLoopWindowSec) * 1000;
+    if (uptimeMs >= windowMs) {
+        delayMs = initialDelayMs;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    failureTimestamps.append(now);
+    while (!failureTimestamps.isEmpty() && now - failureTimestamps.first() > windowMs) {
+        failureTimestamps.removeFirst();
+    }
+
+    if (failureTimestamps.size() > crashLoopLimit) {
+        tripped = true;
+        return -1;
+    }
+
+    int delay = delayMs;
+    delayMs = qMin(delayMs * 2, maxDelayMs);
+    return delay;
+}
+
+bool RestartBackoff::isTripped() const {
+    return tripped;
+}
+
+int RestartBackoff::getRecentFailures() const {
+    return failureTimestamps.size();
+}
+
+int RestartBackoff::getCrashLoopWindowSec() const {
+    return crashLoopWindowSec;
+}
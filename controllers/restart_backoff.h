@@ -0,0 +1,28 @@
+#ifndef RESTART_BACKOFF_H
+#define RESTART_BACKOFF_H
+
+#include <QVector>
+
+// Exponential restart delay with a crash loop breaker: once more than crashLoopLimit
+// failures happened within crashLoopWindowSec, no further restart is allowed until reset().
+class RestartBackoff {
+public:
+    explicit RestartBackoff(int initialDelayMs = 1000, int maxDelayMs = 60000, int crashLoopLimit = 5, int crashLoopWindowSec = 300);
+
+    void reset();
+    int nextDelay(qint64 uptimeMs);
+    bool isTripped() const;
+    int getRecentFailures() const;
+    int getCrashLoopWindowSec() const;
+
+private:
+    int initialDelayMs;
+    int maxDelayMs;
+    int crashLoopLimit;
+    int crashLoopWindowSec;
+    int delayMs;
+    QVector<qint64> failureTimestamps;
+    bool tripped;
+};
+
+#endif // RESTART_BACKOFF_H
@@ -0,0 +1,237 @@
+#include "rolling_restart.h"
+#include "controller.h"
+#include "models/microservice_data.h"
+#include "utils/tracer.h"
+
+#include <QHostAddress>
+#include <QTcpSocket>
+
+namespace {
+const int pollIntervalMs = 500;
+}
+
+RollingRestart::RollingRestart(
+    Model *model,
+    Controller *controller,
+    const QString &commandName,
+    const QStringList &serviceNames,
+    const std::function<QStringList(MicroserviceData*)> &argumentsFor,
+    QObject *parent)
+    : QObject(parent)
+    , model(model)
+    , controller(controller)
+    , commandName(commandName)
+    , options(controller->getCommandOptions(commandName))
+    , argumentsFor(argumentsFor)
+    , queue(serviceNames)
+    , batchNumber(0)
+    , aborted(false)
+    , pollTimer(new QTimer(this))
+{
+    options.rollingBatchSize = qMax(1, options.rollingBatchSize);
+    options.maxFailures = qMax(1, options.maxFailures);
+    batchCount = (queue.size() + options.rollingBatchSize - 1) / options.rollingBatchSize;
+
+    pollTimer->setInterval(pollIntervalMs);
+    connect(pollTimer, &QTimer::timeout, this, &RollingRestart::pollReadiness);
+}
+
+void RollingRestart::start() {
+    startNextBatch();
+}
+
+void RollingRestart::startNextBatch() {
+    batch.clear();
+    if (aborted || queue.isEmpty()) {
+        pollTimer->stop();
+
+        QString summary = QString("%1: restarted %2 of %3 services")
+            .arg(commandName)
+            .arg(restarted.size())
+            .arg(restarted.size() + failed.size() + queue.size());
+        if (!failed.isEmpty()) {
+            summary += ", failed: " + failed.join(", ");
+        }
+        if (aborted && !queue.isEmpty()) {
+            summary += QString(", aborted before %1").arg(queue.join(", "));
+        }
+
+        qDebug() << "Rolling restart finished:" << summary;
+        emit finished(summary);
+        deleteLater();
+        return;
+    }
+
+    TraceSpan span("RollingRestart::startNextBatch", "command", commandName);
+    batchNumber++;
+    while (!queue.isEmpty() && batch.size() < options.rollingBatchSize) {
+        batch.append(queue.takeFirst());
+    }
+
+    emit progress(QString("%1: restarting batch %2/%3 (%4)").arg(commandName).arg(batchNumber).arg(batchCount).arg(batch.join(", ")));
+
+    // Copied, since a script of a supervised service finishes (and may start the next batch) immediately
+    // The ready timeout counts from here, so a script that hangs cannot stall the rollout
+    QStringList currentBatch = batch;
+    for (auto iter = currentBatch.constBegin(); iter != currentBatch.constEnd(); ++iter) {
+        states.insert(*iter, State::Running);
+        waitingSince[*iter].start();
+    }
+
+    if (!pollTimer->isActive()) {
+        pollTimer->start();
+    }
+
+    for (auto iter = currentBatch.constBegin(); iter != currentBatch.constEnd(); ++iter) {
+        QString serviceName = *iter;
+        MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+        if (!microservice) {
+            fail(serviceName, "removed");
+            continue;
+        }
+
+        // Only a health result of the new instance counts
+        microservice->setHealth(HealthState::Unknown, QString());
+        openPorts.remove(serviceName);
+
+        controller->executeScriptAsync(commandName, argumentsFor(microservice), microservice, [this, serviceName](int exitCode) {
+            onScriptFinished(serviceName, exitCode);
+        });
+    }
+}
+
+void RollingRestart::onScriptFinished(const QString &serviceName, int exitCode) {
+    if (states.value(serviceName) != State::Running) {
+        return;
+    }
+
+    if (exitCode != 0) {
+        fail(serviceName, QString("exit code %1").arg(exitCode));
+        return;
+    }
+
+    states.insert(serviceName, State::WaitingForReady);
+    pollReadiness();
+}
+
+void RollingRestart::pollReadiness() {
+    // Statuses are refreshed first, health is only checked for services that are running
+    ProcessTree processTree = ProcessTree::snapshot();
+    bool checkHealth = false;
+    QStringList currentBatch = batch;
+    for (auto iter = currentBatch.constBegin(); iter != currentBatch.constEnd(); ++iter) {
+        State state = states.value(*iter);
+        if (state == State::Running && waitingSince.value(*iter).elapsed() > options.readyTimeoutSec * 1000LL) {
+            fail(*iter, QString("script still running after %1 s").arg(options.readyTimeoutSec));
+            continue;
+        }
+
+        if (state != State::WaitingForReady) {
+            continue;
+        }
+
+        MicroserviceData *microservice = model->getMicroservices().value(*iter);
+        if (microservice) {
+            microservice->refreshCheckboxState(processTree);
+        }
+
+        if (isReady(*iter)) {
+            states.insert(*iter, State::Done);
+            restarted.append(*iter);
+            continue;
+        }
+
+        if (waitingSince.value(*iter).elapsed() > options.readyTimeoutSec * 1000LL) {
+            fail(*iter, QString("not ready after %1 s").arg(options.readyTimeoutSec));
+            continue;
+        }
+
+        checkHealth = checkHealth || (microservice && controller->hasHealthEndpoint(microservice));
+    }
+
+    // Checks of services that are still outstanding are not repeated by the health checker
+    if (checkHealth) {
+        controller->checkHealth();
+    }
+
+    checkBatchDone();
+}
+
+bool RollingRestart::isReady(const QString &serviceName) {
+    MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+    if (!microservice) {
+        return false;
+    }
+
+    // Ports found open belonged to an instance that is gone again
+    if (microservice->getStatus() == MicroserviceStatus::Inactive) {
+        openPorts.remove(serviceName);
+        return false;
+    }
+
+    if (controller->hasHealthEndpoint(microservice)) {
+        return microservice->getHealth() == HealthState::Healthy;
+    }
+
+    // Without a health endpoint a running service is ready when all its ports accept connections
+    QVector<int> ports = microservice->getPorts();
+    QSet<int> open = openPorts.value(serviceName);
+    if (open.size() == ports.size()) {
+        return true;
+    }
+
+    probePorts(serviceName, ports);
+    return false;
+}
+
+void RollingRestart::probePorts(const QString &serviceName, const QVector<int> &ports) {
+    for (int port : ports) {
+        if (openPorts.value(serviceName).contains(port) || probingPorts.value(serviceName).contains(port)) {
+            continue;
+        }
+
+        probingPorts[serviceName].insert(port);
+        QTcpSocket *socket = new QTcpSocket(this);
+        connect(socket, &QTcpSocket::connected, this, [this, socket, serviceName, port]() {
+            probingPorts[serviceName].remove(port);
+            openPorts[serviceName].insert(port);
+            socket->abort();
+            socket->deleteLater();
+        });
+        connect(socket, &QTcpSocket::errorOccurred, this, [this, socket, serviceName, port]() {
+            probingPorts[serviceName].remove(port);
+            socket->deleteLater();
+        });
+        socket->connectToHost(QHostAddress(QHostAddress::LocalHost), static_cast<quint16>(port));
+    }
+}
+
+void RollingRestart::fail(const QString &serviceName, const QString &reason) {
+    qWarning() << "Rolling restart of" << serviceName << "failed:" << reason;
+    states.insert(serviceName, State::Failed);
+    failed.append(serviceName + " (" + reason + ")");
+
+    if (failed.size() >= options.maxFailures && !aborted) {
+        aborted = true;
+        emit progress(QString("%1: %2 services failed, no further batches are started").arg(commandName).arg(failed.size()));
+    }
+
+    checkBatchDone();
+}
+
+void RollingRestart::checkBatchDone() {
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    for (auto iter = batch.constBegin(); iter != batch.constEnd(); ++iter) {
+        State state = states.value(*iter);
+        if (state != State::Done && state != State::Failed) {
+            return;
+        }
+    }
+
+    pollTimer->stop();
+    QTimer::singleShot(0, this, &RollingRestart::startNextBatch);
+    batch.clear();
+}
@@ -0,0 +1,75 @@
+#ifndef ROLLING_RESTART_H
+#define ROLLING_RESTART_H
+
+#include "command.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+#include <functional>
+
+class Controller;
+class Model;
+class MicroserviceData;
+
+// Restarts services in batches: the next batch is started only when every service of the
+// current one is ready again (healthy, or all ports accepting connections), and no further
+// batch is started once maxFailures services failed to restart or to become ready.
+class RollingRestart : public QObject
+{
+    Q_OBJECT
+public:
+    RollingRestart(
+        Model *model,
+        Controller *controller,
+        const QString &commandName,
+        const QStringList &serviceNames,
+        const std::function<QStringList(MicroserviceData*)> &argumentsFor,
+        QObject *parent = nullptr);
+
+    void start();
+
+signals:
+    void progress(const QString &message);
+    void finished(const QString &summary);
+
+private:
+    enum class State {
+        Running,
+        WaitingForReady,
+        Done,
+        Failed
+    };
+
+    void startNextBatch();
+    void onScriptFinished(const QString &serviceName, int exitCode);
+    void pollReadiness();
+    bool isReady(const QString &serviceName);
+    void probePorts(const QString &serviceName, const QVector<int> &ports);
+    void fail(const QString &serviceName, const QString &reason);
+    void checkBatchDone();
+
+    Model *model;
+    Controller *controller;
+    QString commandName;
+    CommandOptions options;
+    std::function<QStringList(MicroserviceData*)> argumentsFor;
+    QStringList queue;
+    QStringList batch;
+    QHash<QString, State> states;
+    QHash<QString, QElapsedTimer> waitingSince;
+    QHash<QString, QSet<int>> openPorts;
+    QHash<QString, QSet<int>> probingPorts;
+    QStringList restarted;
+    QStringList failed;
+    int batchNumber;
+    int batchCount;
+    bool aborted;
+    QTimer *pollTimer;
+};
+
+#endif // ROLLING_RESTART_H
@@ -0,0 +1,297 @@
+#include "source_watcher.h"
+#include "models/source_fingerprint.h"
+#include "utils/tracer.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(Q_OS_LINUX)
+// Content changes are seen once the file is closed, so an editor saving a file causes a single event
+const quint32 watchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_EXCL_UNLINK;
+#endif
+
+}
+
+SourceWatcher::SourceWatcher(const QString &configFile, QObject *parent)
+    : QObject(parent)
+    , inotifyFd(-1)
+    , notifier(nullptr)
+    , watchLimitReported(false)
+{
+    QSettings settings(configFile, QSettings::IniFormat);
+    settings.beginGroup("Watch");
+    WatchSettings defaults;
+    defaults.commandName = settings.value("command").toString();
+    defaults.commandArgs = settings.value("args").toStringList();
+    defaults.ignored = settings.value("ignore", SourceFingerprint::defaultIgnored).toStringList();
+    defaults.debounceMs = settings.value("debounceMs", defaults.debounceMs).toInt();
+    settings.endGroup();
+
+    // Each Watch_<Name> section opts a service in; its ignore list adds to the common one
+    foreach (const QString &group, settings.childGroups()) {
+        if (!group.startsWith("Watch_")) {
+            continue;
+        }
+
+        settings.beginGroup(group);
+        if (settings.value("enabled", true).toBool()) {
+            WatchSettings watchSettings = defaults;
+            watchSettings.commandName = settings.value("command", defaults.commandName).toString();
+            watchSettings.commandArgs = settings.value("args", defaults.commandArgs).toStringList();
+            watchSettings.ignored += settings.value("ignore").toStringList();
+            watchSettings.debounceMs = settings.value("debounceMs", defaults.debounceMs).toInt();
+            configured.insert(group.mid(QString("Watch_").length()), watchSettings);
+        }
+        settings.endGroup();
+    }
+
+    if (configured.isEmpty()) {
+        return;
+    }
+
+#if defined(Q_OS_LINUX)
+    inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd == -1) {
+        qWarning() << "Failed to initialize inotify:" << strerror(errno);
+        return;
+    }
+
+    notifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &SourceWatcher::readEvents);
+#else
+    qWarning() << "Watching sources is only supported on Linux";
+#endif
+}
+
+SourceWatcher::~SourceWatcher() {
+    qDeleteAll(services);
+
+#if defined(Q_OS_LINUX)
+    if (inotifyFd != -1) {
+        ::close(inotifyFd);
+    }
+#endif
+}
+
+bool SourceWatcher::isConfigured(const QString &serviceName) const {
+    return configured.contains(serviceName);
+}
+
+void SourceWatcher::setServices(const QHash<QString, QString> &folders) {
+    if (inotifyFd == -1) {
+        return;
+    }
+
+    foreach (const QString &serviceName, services.keys()) {
+        if (folders.value(serviceName) != services.value(serviceName)->root) {
+            unwatchService(serviceName);
+        }
+    }
+
+    for (auto iter = folders.constBegin(); iter != folders.constEnd(); ++iter) {
+        if (configured.contains(iter.key()) && !services.contains(iter.key())) {
+            watchService(iter.key(), iter.value());
+        }
+    }
+}
+
+void SourceWatcher::setPaused(const QString &serviceName, bool paused) {
+    WatchedService *service = services.value(serviceName);
+    if (!service) {
+        return;
+    }
+
+    // Changes seen so far are covered by the command that pauses the service
+    service->paused = paused;
+    service->changes = 0;
+    service->debounceTimer->stop();
+    if (!paused) {
+        service->resumed.start();
+    }
+}
+
+void SourceWatcher::watchService(const QString &serviceName, const QString &root) {
+    TraceSpan span("SourceWatcher::watchService", "watch", serviceName);
+
+    WatchedService *service = new WatchedService;
+    service->root = root;
+    service->settings = configured.value(serviceName);
+    foreach (const QString &pattern, service->settings.ignored) {
+        service->ignored.append(QRegularExpression(QRegularExpression::wildcardToRegularExpression(pattern)));
+    }
+
+    service->debounceTimer = new QTimer(this);
+    service->debounceTimer->setSingleShot(true);
+    connect(service->debounceTimer, &QTimer::timeout, this, [this, serviceName]() {
+        WatchedService *changed = services.value(serviceName);
+        if (!changed) {
+            return;
+        }
+
+        qDebug() << "Sources of" << serviceName << "changed:" << changed->changes << "events, last" << changed->lastChange;
+        changed->changes = 0;
+        emit sourcesChanged(serviceName, changed->settings.commandName, changed->settings.commandArgs);
+    });
+
+    services.insert(serviceName, service);
+    addTree(serviceName, root);
+}
+
+void SourceWatcher::unwatchService(const QString &serviceName) {
+    WatchedService *service = services.take(serviceName);
+    if (!service) {
+        return;
+    }
+
+    removeTree(service->root);
+    delete service->debounceTimer;
+    delete service;
+}
+
+void SourceWatcher::addTree(const QString &serviceName, const QString &path) {
+#if defined(Q_OS_LINUX)
+    const WatchedService *service = services.value(serviceName);
+
+    // Ignored directories are never entered, so build output and dependencies cost no watches
+    QStringList pending(path);
+    while (!pending.isEmpty()) {
+        QString directory = pending.takeLast();
+        if (descriptors.contains(directory)) {
+            continue;
+        }
+
+        int descriptor = ::inotify_add_watch(inotifyFd, QFile::encodeName(directory).constData(), watchMask | IN_ONLYDIR);
+        if (descriptor == -1) {
+            if (errno == ENOSPC && !watchLimitReported) {
+                qWarning() << "inotify watch limit reached, raise fs.inotify.max_user_watches to watch all sources";
+                watchLimitReported = true;
+            }
+            continue;
+        }
+
+        directories.insert(descriptor, {serviceName, directory});
+        descriptors.insert(directory, descriptor);
+
+        QDir dir(directory);
+        foreach (const QString &child, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks | QDir::Hidden)) {
+            if (!isIgnored(service, child)) {
+                pending.append(dir.filePath(child));
+            }
+        }
+    }
+#else
+    Q_UNUSED(serviceName);
+    Q_UNUSED(path);
+#endif
+}
+
+void SourceWatcher::removeTree(const QString &path) {
+#if defined(Q_OS_LINUX)
+    const QString prefix = path + "/";
+    foreach (const QString &directory, descriptors.keys()) {
+        if (directory == path || directory.startsWith(prefix)) {
+            int descriptor = descriptors.take(directory);
+            directories.remove(descriptor);
+            ::inotify_rm_watch(inotifyFd, descriptor);
+        }
+    }
+#else
+    Q_UNUSED(path);
+#endif
+}
+
+void SourceWatcher::readEvents() {
+#if defined(Q_OS_LINUX)
+    alignas(struct inotify_event) char buffer[64 * 1024];
+
+    while (true) {
+        ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (char *position = buffer; position < buffer + length; ) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>(position);
+            position += sizeof(struct inotify_event) + event->len;
+
+            // Lost events could have been anything, so every watched service counts as changed
+            if (event->mask & IN_Q_OVERFLOW) {
+                qWarning() << "inotify event queue overflowed";
+                for (auto iter = services.constBegin(); iter != services.constEnd(); ++iter) {
+                    markChanged(iter.key(), iter.value()->root);
+                }
+                continue;
+            }
+
+            if (!directories.contains(event->wd)) {
+                continue;
+            }
+
+            // The kernel drops the watch of a deleted directory by itself
+            const WatchedDirectory directory = directories.value(event->wd);
+            if (event->mask & IN_IGNORED) {
+                directories.remove(event->wd);
+                if (descriptors.value(directory.path) == event->wd) {
+                    descriptors.remove(directory.path);
+                }
+                continue;
+            }
+
+            const WatchedService *service = services.value(directory.serviceName);
+            QString name = event->len > 0 ? QFile::decodeName(event->name) : QString();
+            if (!service || (!name.isEmpty() && isIgnored(service, name))) {
+                continue;
+            }
+
+            QString path = name.isEmpty() ? directory.path : QDir(directory.path).filePath(name);
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    addTree(directory.serviceName, path);
+                } else if (event->mask & IN_MOVED_FROM) {
+                    removeTree(path);
+                }
+            }
+
+            markChanged(directory.serviceName, path);
+        }
+    }
+#endif
+}
+
+void SourceWatcher::markChanged(const QString &serviceName, const QString &path) {
+    WatchedService *service = services.value(serviceName);
+    if (!service) {
+        return;
+    }
+
+    // Events of the command's last writes may be read only after it finished, so they are dropped for
+    // one more debounce time
+    if (service->paused || (service->resumed.isValid() && service->resumed.elapsed() < service->settings.debounceMs)) {
+        return;
+    }
+
+    // Every event restarts the debounce time, so a burst (a build, a checkout) causes one restart
+    service->changes++;
+    service->lastChange = path;
+    service->debounceTimer->start(service->settings.debounceMs);
+}
+
+bool SourceWatcher::isIgnored(const WatchedService *service, const QString &name) const {
+    foreach (const QRegularExpression &pattern, service->ignored) {
+        if (pattern.match(name).hasMatch()) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,73 @@
+#ifndef SOURCE_WATCHER_H
+#define SOURCE_WATCHER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QRegularExpression>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+struct WatchSettings {
+    QString commandName;
+    QStringList commandArgs;
+    QStringList ignored;
+    int debounceMs = 500;
+};
+
+// Watches the folders of services with a Watch_<Name> section for changed sources (Linux, inotify).
+// Every directory of a service tree is watched once; directories created later are added as they
+// appear, so an event never causes a rescan. Events are coalesced per service until the service
+// was quiet for its debounce time. Events of a paused service are dropped, so a restart does not
+// trigger itself through the files it writes.
+class SourceWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SourceWatcher(const QString &configFile, QObject *parent = nullptr);
+    ~SourceWatcher();
+
+    bool isConfigured(const QString &serviceName) const;
+    void setServices(const QHash<QString, QString> &folders);
+    void setPaused(const QString &serviceName, bool paused);
+
+signals:
+    void sourcesChanged(const QString &serviceName, const QString &commandName, const QStringList &commandArgs);
+
+private:
+    struct WatchedService {
+        QString root;
+        WatchSettings settings;
+        QVector<QRegularExpression> ignored;
+        QTimer *debounceTimer = nullptr;
+        int changes = 0;
+        QString lastChange;
+        bool paused = false;
+        QElapsedTimer resumed;
+    };
+
+    struct WatchedDirectory {
+        QString serviceName;
+        QString path;
+    };
+
+    void watchService(const QString &serviceName, const QString &root);
+    void unwatchService(const QString &serviceName);
+    void addTree(const QString &serviceName, const QString &path);
+    void removeTree(const QString &path);
+    void readEvents();
+    void markChanged(const QString &serviceName, const QString &path);
+    bool isIgnored(const WatchedService *service, const QString &name) const;
+
+    int inotifyFd;
+    QSocketNotifier *notifier;
+    bool watchLimitReported;
+    QHash<QString, WatchSettings> configured;
+    QHash<QString, WatchedService*> services;
+    QHash<int, WatchedDirectory> directories;
+    QHash<QString, int> descriptors;
+};
+
+#endif // SOURCE_WATCHER_H
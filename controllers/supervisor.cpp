@@ -0,0 +1,221 @@
+#include "supervisor.h"
+#include "models/microservice_data.h"
+#include "models/status_history.h"
+#include "utils/output_log.h"
+
+#if defined(Q_OS_UNIX)
+#include <csignal>
+#endif
+
+Supervisor::Supervisor(QObject *parent)
+    : QObject(parent)
+{}
+
+Supervisor::~Supervisor() {
+    // Supervised services are owned by the launcher and stop together with it.
+    for (auto iter = processes.constBegin(); iter != processes.constEnd(); ++iter) {
+        iter.value()->stopping = true;
+        iter.value()->restartTimer->stop();
+        iter.value()->process->disconnect(this);
+        terminateGroup(iter.value());
+    }
+
+    qDeleteAll(processes);
+}
+
+RestartPolicy Supervisor::restartPolicyFromString(const QString &policy) {
+    if (policy.compare("never", Qt::CaseInsensitive) == 0) {
+        return RestartPolicy::Never;
+    }
+
+    if (policy.compare("always", Qt::CaseInsensitive) == 0) {
+        return RestartPolicy::Always;
+    }
+
+    return RestartPolicy::OnFailure;
+}
+
+void Supervisor::start(MicroserviceData *microservice, const QString &program, const QStringList &arguments, const SupervisionPolicy &policy, const std::function<void()> &childProcessModifier) {
+    const QString serviceName = microservice->getName();
+
+    SupervisedProcess *supervised = processes.value(serviceName);
+    if (supervised && supervised->process->state() != QProcess::NotRunning) {
+        qDebug() << "Service" << serviceName << "is already supervised and running";
+        return;
+    }
+
+    if (!supervised) {
+        supervised = new SupervisedProcess;
+        supervised->microservice = microservice;
+        supervised->process = new QProcess(this);
+        supervised->process->setProcessChannelMode(QProcess::MergedChannels);
+        supervised->restartTimer = new QTimer(this);
+        supervised->restartTimer->setSingleShot(true);
+
+        connect(supervised->process, &QProcess::readyReadStandardOutput, this, [supervised]() {
+            QByteArray output = supervised->process->readAllStandardOutput();
+            qDebug() << "Output:" << supervised->microservice->getName() << output;
+            OutputLog::instance().append(supervised->microservice->getName(), output);
+        });
+        connect(supervised->process, &QProcess::finished, this, [this, supervised](int exitCode, QProcess::ExitStatus exitStatus) {
+            onProcessFinished(supervised, exitCode, exitStatus);
+        });
+        connect(supervised->restartTimer, &QTimer::timeout, this, [this, supervised]() {
+            supervised->restartCount++;
+            StatusHistory::instance()->recordStart(supervised->microservice->getName(), supervised->microservice->getPorts());
+            launch(supervised);
+        });
+
+        processes.insert(serviceName, supervised);
+    }
+
+    #if defined(Q_OS_UNIX)
+        supervised->process->setChildProcessModifier(childProcessModifier);
+    #else
+        Q_UNUSED(childProcessModifier);
+    #endif
+
+    supervised->program = program;
+    supervised->arguments = arguments;
+    supervised->policy = policy;
+    supervised->backoff = RestartBackoff(policy.restartDelayMs, policy.maxRestartDelayMs, policy.crashLoopLimit, policy.crashLoopWindowSec);
+    supervised->restartTimer->stop();
+
+    launch(supervised);
+}
+
+void Supervisor::launch(SupervisedProcess *supervised) {
+    supervised->stopping = false;
+    supervised->process->setProgram(supervised->program);
+    supervised->process->setArguments(supervised->arguments);
+
+    qDebug() << "Starting supervised service:" << supervised->microservice->getName() << "with args:" << supervised->arguments;
+    supervised->process->start();
+    if (!supervised->process->waitForStarted()) {
+        qWarning() << "Failed to start supervised service:" << supervised->microservice->getName() << "Error:" << supervised->process->errorString();
+        supervised->failedToStart = true;
+        supervised->lastExitCode = -1;
+        supervised->uptime.invalidate();
+
+        // A start failure counts like a crash, so a missing program trips the circuit instead of retrying forever
+        if (supervised->policy.restartPolicy != RestartPolicy::Never) {
+            scheduleRestart(supervised);
+            return;
+        }
+
+        updateSupervisionInfo(supervised);
+        emit stateChanged(supervised->microservice->getName());
+        return;
+    }
+
+    supervised->failedToStart = false;
+    supervised->uptime.start();
+    supervised->microservice->setLaunchSessionId(static_cast<int>(supervised->process->processId()));
+    updateSupervisionInfo(supervised);
+}
+
+void Supervisor::stop(const QString &serviceName) {
+    SupervisedProcess *supervised = processes.value(serviceName);
+    if (!supervised) {
+        return;
+    }
+
+    supervised->stopping = true;
+    supervised->restartTimer->stop();
+
+    terminateGroup(supervised);
+    updateSupervisionInfo(supervised);
+}
+
+void Supervisor::terminateGroup(SupervisedProcess *supervised) {
+    if (supervised->process->state() == QProcess::NotRunning) {
+        return;
+    }
+
+    // The service was started in its own session, so the group also reaches processes a wrapper script started
+    #if defined(Q_OS_UNIX)
+        qint64 pid = supervised->process->processId();
+        if (pid > 0 && ::kill(-static_cast<pid_t>(pid), SIGTERM) == 0) {
+            return;
+        }
+    #endif
+
+    supervised->process->terminate();
+}
+
+bool Supervisor::isRunning(const QString &serviceName) const {
+    SupervisedProcess *supervised = processes.value(serviceName);
+    return supervised && supervised->process->state() != QProcess::NotRunning;
+}
+
+bool Supervisor::isSupervised(const QString &serviceName) const {
+    return processes.contains(serviceName);
+}
+
+bool Supervisor::shouldRestart(const SupervisedProcess *supervised, int exitCode, QProcess::ExitStatus exitStatus) const {
+    if (supervised->stopping) {
+        return false;
+    }
+
+    switch (supervised->policy.restartPolicy) {
+    case RestartPolicy::Never:
+        return false;
+    case RestartPolicy::Always:
+        return true;
+    case RestartPolicy::OnFailure:
+        return exitStatus == QProcess::CrashExit || exitCode != 0;
+    }
+
+    return false;
+}
+
+void Supervisor::onProcessFinished(SupervisedProcess *supervised, int exitCode, QProcess::ExitStatus exitStatus) {
+    supervised->lastExitCode = exitStatus == QProcess::CrashExit ? -1 : exitCode;
+    qDebug() << "Supervised service" << supervised->microservice->getName() << "exited with code" << supervised->lastExitCode;
+
+    if (!shouldRestart(supervised, exitCode, exitStatus)) {
+        updateSupervisionInfo(supervised);
+        emit stateChanged(supervised->microservice->getName());
+        return;
+    }
+
+    scheduleRestart(supervised);
+}
+
+void Supervisor::scheduleRestart(SupervisedProcess *supervised) {
+    const int delayMs = supervised->backoff.nextDelay(supervised->uptime.isValid() ? supervised->uptime.elapsed() : 0);
+    if (delayMs < 0) {
+        qWarning() << "Supervised service" << supervised->microservice->getName() << "is crash looping, restarts stopped";
+        updateSupervisionInfo(supervised);
+        emit stateChanged(supervised->microservice->getName());
+        return;
+    }
+
+    qDebug() << "Restarting" << supervised->microservice->getName() << "in" << delayMs << "ms";
+    supervised->restartTimer->start(delayMs);
+
+    updateSupervisionInfo(supervised);
+    emit stateChanged(supervised->microservice->getName());
+}
+
+void Supervisor::updateSupervisionInfo(const SupervisedProcess *supervised) {
+    QString state;
+    if (supervised->backoff.isTripped()) {
+        state = "crash loop";
+    } else if (supervised->restartTimer->isActive()) {
+        state = "restarting";
+    } else if (supervised->process->state() != QProcess::NotRunning) {
+        state = "supervised";
+    } else if (supervised->failedToStart) {
+        state = "failed to start";
+    } else {
+        state = "stopped";
+    }
+
+    QString info = QString("%1, restarts: %2").arg(state).arg(supervised->restartCount);
+    if (supervised->restartCount > 0 || supervised->process->state() == QProcess::NotRunning) {
+        info += QString(", last exit: %1").arg(supervised->lastExitCode);
+    }
+
+    supervised->microservice->setSupervisionInfo(info, supervised->backoff.isTripped() || (supervised->failedToStart && !supervised->restartTimer->isActive()));
+}
@@ -0,0 +1,76 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include "restart_backoff.h"
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QObject>
+#include <QProcess>
+#include <QTimer>
+#include <QVector>
+
+#include <functional>
+
+class MicroserviceData;
+
+enum class RestartPolicy {
+    Never,
+    OnFailure,
+    Always
+};
+
+struct SupervisionPolicy {
+    bool supervised = false;
+    RestartPolicy restartPolicy = RestartPolicy::OnFailure;
+    int restartDelayMs = 1000;
+    int maxRestartDelayMs = 60000;
+    int crashLoopLimit = 5;
+    int crashLoopWindowSec = 300;
+};
+
+// Owns the processes of supervised commands and restarts them according to their policy.
+class Supervisor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Supervisor(QObject *parent = nullptr);
+    ~Supervisor();
+
+    void start(MicroserviceData *microservice, const QString &program, const QStringList &arguments, const SupervisionPolicy &policy, const std::function<void()> &childProcessModifier);
+    void stop(const QString &serviceName);
+    bool isRunning(const QString &serviceName) const;
+    bool isSupervised(const QString &serviceName) const;
+
+    static RestartPolicy restartPolicyFromString(const QString &policy);
+
+signals:
+    void stateChanged(const QString &serviceName);
+
+private:
+    struct SupervisedProcess {
+        MicroserviceData *microservice = nullptr;
+        QProcess *process = nullptr;
+        QTimer *restartTimer = nullptr;
+        QString program;
+        QStringList arguments;
+        SupervisionPolicy policy;
+        QElapsedTimer uptime;
+        RestartBackoff backoff;
+        int restartCount = 0;
+        int lastExitCode = 0;
+        bool stopping = false;
+        bool failedToStart = false;
+    };
+
+    void launch(SupervisedProcess *supervised);
+    void onProcessFinished(SupervisedProcess *supervised, int exitCode, QProcess::ExitStatus exitStatus);
+    void scheduleRestart(SupervisedProcess *supervised);
+    void terminateGroup(SupervisedProcess *supervised);
+    bool shouldRestart(const SupervisedProcess *supervised, int exitCode, QProcess::ExitStatus exitStatus) const;
+    void updateSupervisionInfo(const SupervisedProcess *supervised);
+
+    QMap<QString, SupervisedProcess*> processes;
+};
+
+#endif // SUPERVISOR_H
@@ -1,11 +1,60 @@
 #include "views/mainwindow.h"
+#include "utils/tracer.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QFileInfo>
+#include <QProcessEnvironment>
+#include <QStandardPaths>
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption traceOption("trace", "Write a Chrome trace_event JSON file of startup and refresh phases.", "file");
+    QCommandLineOption benchmarkOption("benchmark", "Run the benchmark scenario, write aggregated timings as JSON and exit.", "file");
+    parser.addOption(traceOption);
+    parser.addOption(benchmarkOption);
+    parser.process(a);
+
+    QString traceFile = parser.value(traceOption);
+    if (traceFile.isEmpty()) {
+        traceFile = QProcessEnvironment::systemEnvironment().value("MICROSERVICE_LAUNCHER_TRACE");
+    }
+
+    QString benchmarkFile = parser.value(benchmarkOption);
+    if (!benchmarkFile.isEmpty()) {
+        // The scenario overwrites save.ini and the service snapshot, so it only runs against generated data
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        if (!QFileInfo::exists(dataDir + "/benchmark")) {
+            qCritical().noquote() << "--benchmark only runs with data created by tools/benchmark/generate_services.sh,"
+                                  << dataDir << "has no benchmark marker";
+            return 1;
+        }
+    }
+    if (!traceFile.isEmpty() || !benchmarkFile.isEmpty()) {
+        Tracer::instance().enable();
+    }
+
     MainWindow w;
     w.show();
-    return a.exec();
+
+    if (!benchmarkFile.isEmpty()) {
+        QTimer::singleShot(0, &w, [&w, &a, benchmarkFile]() {
+            w.runBenchmark(benchmarkFile);
+            a.quit();
+        });
+    }
+
+    int exitCode = a.exec();
+
+    if (!traceFile.isEmpty()) {
+        Tracer::instance().writeTraceFile(traceFile);
+    }
+
+    return exitCode;
 }
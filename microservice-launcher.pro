@@ -1,4 +1,4 @@
-QT       += core gui network
+QT       += core gui network concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -18,7 +18,28 @@ SOURCES += \
     models/model.cpp \
     models/microservice_data.cpp \
     models/microservice_data_map.cpp \
-    controllers/command.cpp
+    controllers/command.cpp \
+    controllers/supervisor.cpp \
+    controllers/cgroup_manager.cpp \
+    controllers/metrics_exporter.cpp \
+    controllers/health_checker.cpp \
+    controllers/rolling_restart.cpp \
+    controllers/graceful_stop.cpp \
+    controllers/restart_backoff.cpp \
+    controllers/crash_monitor.cpp \
+    controllers/source_watcher.cpp \
+    controllers/build_pipeline.cpp \
+    models/process_tree.cpp \
+    models/port_registry.cpp \
+    models/service_discovery.cpp \
+    models/service_snapshot.cpp \
+    models/status_history.cpp \
+    models/source_fingerprint.cpp \
+    utils/tracer.cpp \
+    utils/metrics.cpp \
+    utils/latency_histogram.cpp \
+    utils/output_log.cpp \
+    utils/shell_worker.cpp
 
 HEADERS += \
     views/mainwindow.h \
@@ -27,7 +48,28 @@ HEADERS += \
     models/microservice_data.h \
     models/microservice_status.h \
     models/microservice_data_map.h \
-    controllers/command.h
+    controllers/command.h \
+    controllers/supervisor.h \
+    controllers/cgroup_manager.h \
+    controllers/metrics_exporter.h \
+    controllers/health_checker.h \
+    controllers/rolling_restart.h \
+    controllers/graceful_stop.h \
+    controllers/restart_backoff.h \
+    controllers/crash_monitor.h \
+    controllers/source_watcher.h \
+    controllers/build_pipeline.h \
+    models/process_tree.h \
+    models/port_registry.h \
+    models/service_discovery.h \
+    models/service_snapshot.h \
+    models/status_history.h \
+    models/source_fingerprint.h \
+    utils/tracer.h \
+    utils/metrics.h \
+    utils/latency_histogram.h \
+    utils/output_log.h \
+    utils/shell_worker.h
 
 FORMS += \
     views/mainwindow.ui
@@ -1,86 +1,111 @@
 #include "microservice_data.h"
+#include "utils/tracer.h"
+#include "port_registry.h"
+#include "status_history.h"
+#include "utils/metrics.h"
 
 #include <QCoreApplication>
 #include <QProcessEnvironment>
 #include <QTcpSocket>
 #include <QDir>
 #include <QStandardPaths>
-
-MicroserviceData::MicroserviceData(const QString name, const QString directory)
-    : name(name)
-    , shortName(readApplicationShortNameFromFile(QDir(directory).filePath(name)))
-    , ports(readPortsFromFile(directory))
+#include <QElapsedTimer>
+
+MicroserviceData::MicroserviceData(const ServiceInfo &info)
+    : name(info.name)
+    , folderName(info.folderName)
+    , directory(info.directory)
+    , shortName(info.shortName)
+    , ports(info.ports)
+    , healthEndpoint(info.healthEndpoint)
+    , dependencies(info.dependencies)
+    , tags(info.tags)
+    , launchSessionId(0)
+    , flagsVisible(false)
     , flagsLayout(new QHBoxLayout)
     , microserviceLayout(new QVBoxLayout)
 {
     flagsLayout->setAlignment(Qt::AlignLeft);
     flagsLayout->setSpacing(10);
 
-    QString folderInfo = getFolderInfo();
-    checkBox = new QCheckBox(name + folderInfo);
+    checkBox = new QCheckBox();
     checkBox->setFocusPolicy(Qt::StrongFocus);
+    updateCheckBoxText();
 
     statusCheckBox = new QCheckBox();
     statusCheckBox->setEnabled(false);
 
     enabledFlagsLabel = new QLabel(getEnabledFlags().join(", "));
     enabledFlagsLabel->setStyleSheet("color: #7161d4;");
-}
 
-QString MicroserviceData::readApplicationShortNameFromFile(const QString& filePath) const {
-    QStringList args;
-    args << filePath;
+    supervisionLabel = new QLabel();
+    supervisionLabel->setVisible(false);
 
-    QProcess process;
-    QString scriptPath = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("short_name.sh");
-    process.start(scriptPath, args);
-    if (!process.waitForStarted() || !process.waitForFinished()) {
-        qWarning() << "Failed to execute script:" << process.errorString();
-        return QString();
-    }
+    resourceLabel = new QLabel();
+    resourceLabel->setStyleSheet("color: gray;");
+    resourceLabel->setVisible(false);
 
-    if (process.exitCode() != 0) {
-        qWarning() << "Process failed with exit code:" << process.exitCode() << "Error:" << process.readAllStandardOutput();
-        return QString();
-    }
+    healthLabel = new QLabel();
+    healthLabel->setVisible(false);
+    health = HealthState::Unknown;
 
-    QString output = process.readAllStandardOutput().trimmed();
-    return output;
+    // A status restored from the snapshot is shown but not recorded as a transition
+    status = info.status;
+    updateStatusCheckBox();
 }
 
-QVector<int> MicroserviceData::readPortsFromFile(const QString directory) const {
-    QVector<int> ports;
-
-    QStringList args;
-    args << QDir(directory).filePath(name)
-         << shortName;
+MicroserviceData::~MicroserviceData() {
+    Metrics::instance().removeSeries("service", name);
+    qDeleteAll(flagCheckBoxes);
+    delete checkBox;
+    delete statusCheckBox;
+    delete enabledFlagsLabel;
+    delete supervisionLabel;
+    delete resourceLabel;
+    delete healthLabel;
+    delete microserviceLayout;
+}
 
-    QProcess process;
-    QString scriptPath = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("ports.sh");
-    process.start(scriptPath, args);
-    if (!process.waitForStarted() || !process.waitForFinished()) {
-        qWarning() << "Failed to execute script:" << process.errorString();
-        return ports;
-    }
+ServiceInfo MicroserviceData::getServiceInfo() const {
+    ServiceInfo info;
+    info.name = name;
+    info.folderName = folderName;
+    info.directory = directory;
+    info.shortName = shortName;
+    info.ports = ports;
+    info.healthEndpoint = healthEndpoint;
+    info.dependencies = dependencies;
+    info.tags = tags;
+    info.status = status;
+    return info;
+}
 
-    if (process.exitCode() != 0) {
-        qWarning() << "Process failed with exit code:" << process.exitCode() << "Error:" << process.readAllStandardOutput();
-        return ports;
+bool MicroserviceData::updateServiceInfo(const ServiceInfo &info) {
+    if (info.shortName == shortName && info.ports == ports && info.healthEndpoint == healthEndpoint
+        && info.dependencies == dependencies && info.tags == tags) {
+        return false;
     }
 
-    QString output = process.readAllStandardOutput().trimmed();
+    shortName = info.shortName;
+    ports = info.ports;
+    healthEndpoint = info.healthEndpoint;
+    dependencies = info.dependencies;
+    tags = info.tags;
+    updateCheckBoxText();
+    return true;
+}
 
-    QStringList parts = output.split(" ");
+void MicroserviceData::updateCheckBoxText() {
+    checkBox->setText(name + getFolderInfo());
 
-    for (auto iter = parts.constBegin(); iter != parts.constEnd(); ++iter) {
-        bool ok;
-        int port = iter->toInt(&ok);
-        if (ok) {
-            ports.append(port);
-        }
+    QStringList toolTip;
+    if (!tags.isEmpty()) {
+        toolTip << "Tags: " + tags.join(", ");
     }
-
-    return ports;
+    if (!dependencies.isEmpty()) {
+        toolTip << "Depends on: " + dependencies.join(", ");
+    }
+    checkBox->setToolTip(toolTip.join("\n"));
 }
 
 QString MicroserviceData::getFolderInfo() const {
@@ -107,82 +132,151 @@ QString MicroserviceData::getFolderInfo() const {
     return folderInfo;
 }
 
-int MicroserviceData::getPid() const {
-    QProcess process;
-    QStringList arguments;
+QVector<int> MicroserviceData::getPids(const ProcessTree &processTree) const {
+    return findPids(folderName, launchSessionId, processTree);
+}
+
+QVector<int> MicroserviceData::findPids(const QString &processName, int sessionId, const ProcessTree &processTree) {
+    QVector<int> pids = processTree.getPidsInSession(sessionId);
 
     #if defined(Q_OS_LINUX)
-        arguments << "-C" << name << "-o" << "pid=";
-        process.start("ps", arguments);
+        foreach (int pid, processTree.getPidsByName(processName)) {
+            if (!pids.contains(pid)) {
+                pids.append(pid);
+            }
+        }
     #elif defined(Q_OS_MACOS)
-        arguments << "-x" << name;
-        process.start("pgrep", arguments);
+        QProcess process;
+        process.start("pgrep", QStringList() << "-x" << processName);
+
+        if (!process.waitForStarted() || !process.waitForFinished()) {
+            qWarning() << "Failed to start process";
+            return pids;
+        }
+
+        if (process.exitStatus() != QProcess::NormalExit) {
+            qWarning() << "Process did not exit normally";
+            return pids;
+        }
+
+        // pgrep prints one PID per line when several processes match
+        QStringList lines = QString(process.readAllStandardOutput()).split('\n', Qt::SkipEmptyParts);
+        for (auto iter = lines.constBegin(); iter != lines.constEnd(); ++iter) {
+            bool ok;
+            int pid = iter->trimmed().toInt(&ok);
+            if (ok && !pids.contains(pid)) {
+                pids.append(pid);
+            }
+        }
     #else
         qWarning() << "Platform not supported";
-        return -1;
     #endif
 
-    if (!process.waitForStarted()) {
-        qWarning() << "Failed to start process";
-        return -1;
+    return pids;
+}
+
+bool MicroserviceData::checkDebug(const QString &serviceName, const QVector<int> &servicePorts) {
+    if (servicePorts.isEmpty()) {
+        qDebug() << "No ports found for folder" << serviceName;
+        return false;
     }
 
-    process.waitForFinished();
+    for (int port : servicePorts) {
+        QElapsedTimer timer;
+        timer.start();
 
-    if (process.exitStatus() != QProcess::NormalExit) {
-        qWarning() << "Process did not exit normally";
-        return -1;
-    }
+        QTcpSocket socket;
+        socket.connectToHost("127.0.0.1", port);
+        bool connected = socket.waitForConnected(1000);
+        Metrics::instance().observe("launcher_probe_duration_seconds", {{"service", serviceName}, {"port", QString::number(port)}}, timer.nsecsElapsed() / 1e9);
 
-    QString output = process.readAllStandardOutput().trimmed();
-    if (output.isEmpty()) {
-        return -1; // Return -1 if process is not found
+        if (connected) {
+            return true;
+        }
     }
 
-    bool ok;
-    int pid = output.toInt(&ok);
-    if (!ok) {
-        qWarning() << "Failed to convert output to PID";
-        return -1;
-    }
+    return false;
+}
 
-    return pid;
+void MicroserviceData::refreshCheckboxState() {
+    refreshCheckboxState(ProcessTree::snapshot());
 }
 
-bool MicroserviceData::checkDebug() const {
-    if (ports.isEmpty()) {
-        qDebug() << "No ports found for folder" << name;
-        return false;
+void MicroserviceData::refreshCheckboxState(const ProcessTree &processTree) {
+    TraceSpan span("MicroserviceData::refreshCheckboxState", "status", name);
+    applyProbe(probe(getServiceInfo(), launchSessionId, processTree), processTree);
+}
+
+ServiceProbe MicroserviceData::probe(const ServiceInfo &info, int sessionId, const ProcessTree &processTree) {
+    TraceSpan span("MicroserviceData::probe", "status", info.name);
+    ServiceProbe result;
+
+    if (sessionId > 0 && processTree.getPidsInSession(sessionId).isEmpty()) {
+        result.exitedSessionId = sessionId;
+        sessionId = 0;
     }
 
-    for (int port : ports) {
-        QTcpSocket socket;
-        socket.connectToHost("127.0.0.1", port);
-        if (socket.waitForConnected(1000)) {
-            return true;
-        }
+    result.pids = findPids(info.folderName, sessionId, processTree);
+    if (!result.pids.isEmpty()) {
+        result.status = MicroserviceStatus::Active;
+    } else if (checkDebug(info.name, info.ports)) {
+        result.status = MicroserviceStatus::Debug;
     }
 
-    return false;
+    return result;
 }
 
-bool MicroserviceData::isServiceRunning() const {
-    return getPid() == -1 ? false : true;
+void MicroserviceData::applyProbe(const ServiceProbe &result, const ProcessTree &processTree) {
+    // A session started after the probe was taken is kept
+    if (result.exitedSessionId > 0 && result.exitedSessionId == launchSessionId) {
+        qDebug() << "Launched processes of" << name << "have exited";
+        launchSessionId = 0;
+    }
+
+    lastPids = result.pids;
+    setStatus(result.status);
+    updateProcessMetrics(processTree);
 }
 
-void MicroserviceData::refreshCheckboxState() {
-    bool isRunning = isServiceRunning();
-    bool isDebug = isRunning ? false : checkDebug();
+void MicroserviceData::updateProcessMetrics(const ProcessTree &processTree) const {
+    qint64 cpuTimeMs = 0;
+    qint64 residentBytes = 0;
+    foreach (int pid, lastPids) {
+        ProcessInfo info = processTree.value(pid);
+        cpuTimeMs += info.cpuTimeMs;
+        residentBytes += info.residentBytes;
+    }
 
-    statusCheckBox->setChecked(isRunning ? isRunning : isDebug);
-    statusCheckBox->setStyleSheet(isDebug ? "background-color: green;" : "");
-    status = isRunning ? MicroserviceStatus::Active : isDebug ? MicroserviceStatus::Debug : MicroserviceStatus::Inactive;
+    const MetricLabels labels = {{"service", name}};
+    Metrics &metrics = Metrics::instance();
+    metrics.setGauge("launcher_service_pid", labels, lastPids.isEmpty() ? 0 : lastPids.first());
+    metrics.setGauge("launcher_service_processes", labels, lastPids.size());
+    metrics.setGauge("launcher_service_cpu_seconds", labels, cpuTimeMs / 1000.0);
+    metrics.setGauge("launcher_service_resident_memory_bytes", labels, residentBytes);
 }
 
 MicroserviceStatus MicroserviceData::getStatus() const {
     return status;
 }
 
+void MicroserviceData::setStatus(MicroserviceStatus newStatus) {
+    status = newStatus;
+    updateStatusCheckBox();
+    StatusHistory::instance()->recordStatus(name, status);
+
+    const MicroserviceStatus statuses[] = {MicroserviceStatus::Active, MicroserviceStatus::Debug, MicroserviceStatus::Inactive};
+    for (MicroserviceStatus labelStatus : statuses) {
+        Metrics::instance().setGauge("launcher_service_status", {{"service", name}, {"status", microserviceStatusToString(labelStatus)}}, labelStatus == status ? 1 : 0);
+    }
+}
+
+void MicroserviceData::updateStatusCheckBox() {
+    bool isDebug = status == MicroserviceStatus::Debug;
+
+    statusCheckBox->setChecked(status != MicroserviceStatus::Inactive);
+    statusCheckBox->setStyleSheet(isDebug ? "background-color: green;" : "");
+}
+
 QString MicroserviceData::getShortName() const {
     return shortName;
 }
@@ -191,6 +285,14 @@ QString MicroserviceData::getName() const {
     return name;
 }
 
+QString MicroserviceData::getFolderName() const {
+    return folderName;
+}
+
+QString MicroserviceData::getDirectory() const {
+    return directory;
+}
+
 void MicroserviceData::setCheckBoxChecked(bool checked) {
     checkBox->setChecked(checked);
 }
@@ -207,15 +309,49 @@ QVector<int> MicroserviceData::getPorts() const {
     return ports;
 }
 
+QString MicroserviceData::getHealthEndpoint() const {
+    return healthEndpoint;
+}
+
+QStringList MicroserviceData::getDependencies() const {
+    return dependencies;
+}
+
+QStringList MicroserviceData::getTags() const {
+    return tags;
+}
+
+bool MicroserviceData::matches(const QString &searchText) const {
+    if (searchText.isEmpty() || checkBox->text().contains(searchText, Qt::CaseInsensitive)) {
+        return true;
+    }
+
+    foreach (const QString &tag, tags) {
+        if (tag.contains(searchText, Qt::CaseInsensitive)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void MicroserviceData::setFlagsVisible(bool visible){
-    foreach (QCheckBox *checkBox, flagCheckBoxes) {
-        if (visible) {
-            flagsLayout->addWidget(checkBox);
-            checkBox->show();
-        } else {
+    if (visible == flagsVisible) {
+        return;
+    }
+
+    flagsVisible = visible;
+    if (visible) {
+        foreach (const QString &flag, flagNames) {
+            flagCheckBoxes.append(createFlagCheckBox(flag));
+        }
+    } else {
+        foreach (QCheckBox *checkBox, flagCheckBoxes) {
             flagsLayout->removeWidget(checkBox);
-            checkBox->hide();
+            checkBox->deleteLater();
         }
+
+        flagCheckBoxes.clear();
     }
 }
 
@@ -227,35 +363,58 @@ QVBoxLayout* MicroserviceData::getMicroserviceLayout() const {
     return microserviceLayout;
 }
 
-void MicroserviceData::addFlag(const QString flag, bool visible, bool check) {
-    QCheckBox *flagCheckBox = new QCheckBox(flag);
-    flagCheckBox->setChecked(check);
-    flagCheckBoxes.append(flagCheckBox);
+void MicroserviceData::addFlag(const QString flag, bool check) {
+    if (flagNames.contains(flag)) {
+        return;
+    }
 
-    if (visible) {
-        flagsLayout->addWidget(flagCheckBox);
+    flagNames.append(flag);
+    if (check) {
+        enabledFlags.insert(flag);
+    }
+
+    if (flagsVisible) {
+        flagCheckBoxes.append(createFlagCheckBox(flag));
     }
+}
+
+QCheckBox* MicroserviceData::createFlagCheckBox(const QString &flag) {
+    QCheckBox *flagCheckBox = new QCheckBox(flag);
+    flagCheckBox->setChecked(enabledFlags.contains(flag));
+    flagsLayout->addWidget(flagCheckBox);
 
     QObject *context = new QObject(flagCheckBox);
 
-    flagCheckBox->connect(flagCheckBox, &QCheckBox::checkStateChanged, context, [this]() {
-        updateEnabledFlagsLabel();
+    flagCheckBox->connect(flagCheckBox, &QCheckBox::checkStateChanged, context, [this, flag](Qt::CheckState state) {
+        setFlagEnabled(flag, state == Qt::Checked);
     });
+
+    return flagCheckBox;
+}
+
+void MicroserviceData::setFlagEnabled(const QString &flag, bool enabled) {
+    if (enabled) {
+        enabledFlags.insert(flag);
+    } else {
+        enabledFlags.remove(flag);
+    }
+
+    updateEnabledFlagsLabel();
 }
 
 QStringList MicroserviceData::getEnabledFlags() const {
-    QStringList enabledFlags;
-    foreach (QCheckBox *checkBox, flagCheckBoxes) {
-        if (checkBox->isChecked()) {
-            enabledFlags << checkBox->text();
+    QStringList flags;
+    foreach (const QString &flag, flagNames) {
+        if (enabledFlags.contains(flag)) {
+            flags << flag;
         }
     }
 
-    return enabledFlags;
+    return flags;
 }
 
-QVector<QCheckBox*> MicroserviceData::getFlagCheckBoxes() const {
-    return flagCheckBoxes;
+bool MicroserviceData::isFlagEnabled(const QString &flag) const {
+    return enabledFlags.contains(flag);
 }
 
 void MicroserviceData::updateEnabledFlagsLabel() {
@@ -273,12 +432,76 @@ QLabel* MicroserviceData::getEnabledFlagsLabel() const {
     return enabledFlagsLabel;
 }
 
-void MicroserviceData::updateFlagState(const QString flag, const Qt::CheckState state) const {
+QLabel* MicroserviceData::getSupervisionLabel() const {
+    return supervisionLabel;
+}
+
+void MicroserviceData::setSupervisionInfo(const QString &info, bool failed, const QString &details) {
+    supervisionLabel->setText(info);
+    supervisionLabel->setStyleSheet(failed ? "color: #d9534f;" : "color: gray;");
+    supervisionLabel->setToolTip(details);
+    supervisionLabel->setVisible(!info.isEmpty());
+}
+
+QLabel* MicroserviceData::getResourceLabel() const {
+    return resourceLabel;
+}
+
+void MicroserviceData::setResourceUsage(const QString &usage) {
+    resourceLabel->setText(usage);
+    resourceLabel->setVisible(!usage.isEmpty());
+}
+
+QLabel* MicroserviceData::getHealthLabel() const {
+    return healthLabel;
+}
+
+void MicroserviceData::setHealth(HealthState state, const QString &details) {
+    health = state;
+
+    switch (state) {
+    case HealthState::Healthy:
+        healthLabel->setStyleSheet("color: #5cb85c;");
+        break;
+    case HealthState::Degraded:
+        healthLabel->setStyleSheet("color: #f0ad4e;");
+        break;
+    case HealthState::Down:
+        healthLabel->setStyleSheet("color: #d9534f;");
+        break;
+    case HealthState::Unknown:
+        break;
+    }
+
+    healthLabel->setText(healthStateToString(state).toLower());
+    healthLabel->setToolTip(details);
+    healthLabel->setVisible(state != HealthState::Unknown);
+}
+
+HealthState MicroserviceData::getHealth() const {
+    return health;
+}
+
+void MicroserviceData::updateFlagState(const QString flag, const Qt::CheckState state) {
+    if (!flagNames.contains(flag)) {
+        return;
+    }
+
     foreach (QCheckBox *checkBox, flagCheckBoxes) {
         if (checkBox->text() == flag) {
             checkBox->setCheckState(state);
         }
     }
+
+    setFlagEnabled(flag, state == Qt::Checked);
+}
+
+int MicroserviceData::getLaunchSessionId() const {
+    return launchSessionId;
+}
+
+void MicroserviceData::setLaunchSessionId(int sessionId) {
+    launchSessionId = sessionId;
 }
 
 QString MicroserviceData::getPIDByPorts() const {
@@ -288,22 +511,13 @@ QString MicroserviceData::getPIDByPorts() const {
         return "";
     }
 
-    for (auto iter = ports.constBegin(); iter != ports.constEnd(); ++iter) {
-        int port = *iter;
-        QString cmd = "lsof -i :" + QString::number(port) + " -t";
-        QProcess process;
-
-        process.start("/usr/bin/env", QStringList() << "bash" << "-c" << cmd);
-        process.waitForFinished();
-
-        QString result = process.readAllStandardOutput().trimmed();
-        if (!result.isEmpty()) {
-            qDebug() << "Found PID for port" << port << ":" << result;
-            return result;
-        } else {
-            qDebug() << "No PID found for port" << port;
-        }
+    // The listening sockets are looked up directly, without a shell or lsof on Linux; the first port in order wins
+    int pid = PortRegistry::findListenerPid(ports);
+    if (pid <= 0) {
+        qDebug() << "No PID found for ports" << ports;
+        return ""; // Return empty if no process is found on any port
     }
 
-    return ""; // Return empty if no process is found on any port
+    qDebug() << "Found PID for ports" << ports << ":" << pid;
+    return QString::number(pid);
 }
@@ -2,55 +2,105 @@
 #define MICROSERVICE_DATA_H
 
 #include "microservice_status.h"
+#include "process_tree.h"
+#include "service_discovery.h"
 
 #include <QCheckBox>
 #include <QVBoxLayout>
 #include <QLabel>
+#include <QSet>
 
 class Model;
 
+// Result of checking whether a service runs, computed without touching widgets so it can be done on a worker thread.
+struct ServiceProbe {
+    MicroserviceStatus status = MicroserviceStatus::Inactive;
+    QVector<int> pids;
+    int exitedSessionId = 0; // launch session whose processes have all exited
+};
+
 class MicroserviceData {
 public:
-    MicroserviceData(const QString name, const QString directory);
+    explicit MicroserviceData(const ServiceInfo &info);
+    ~MicroserviceData();
+    ServiceInfo getServiceInfo() const;
+    bool updateServiceInfo(const ServiceInfo &info);
     void refreshCheckboxState();
+    void refreshCheckboxState(const ProcessTree &processTree);
+    static ServiceProbe probe(const ServiceInfo &info, int sessionId, const ProcessTree &processTree);
+    void applyProbe(const ServiceProbe &result, const ProcessTree &processTree);
     MicroserviceStatus getStatus() const;
+    void setStatus(MicroserviceStatus newStatus);
     QString getShortName() const;
     QString getName() const;
+    QString getFolderName() const;
+    QString getDirectory() const;
     QVector<int> getPorts() const;
+    QString getHealthEndpoint() const;
+    QStringList getDependencies() const;
+    QStringList getTags() const;
+    bool matches(const QString &searchText) const;
     void setCheckBoxChecked(bool checked);
     QCheckBox* getCheckBox();
     QCheckBox* getStatusCheckBox();
     QHBoxLayout* getFlagsLayout() const;
     QVBoxLayout* getMicroserviceLayout() const;
-    void addFlag(const QString flag, bool visible, bool check = false);
+    void addFlag(const QString flag, bool check = false);
     void setFlagsVisible(bool visible);
     QStringList getEnabledFlags() const;
-    QVector<QCheckBox*> getFlagCheckBoxes() const;
+    bool isFlagEnabled(const QString &flag) const;
     QLabel* getEnabledFlagsLabel() const;
-    void updateFlagState(const QString flag, const Qt::CheckState state) const;
-    int getPid() const;
+    QLabel* getSupervisionLabel() const;
+    void setSupervisionInfo(const QString &info, bool failed, const QString &details = QString());
+    QLabel* getResourceLabel() const;
+    void setResourceUsage(const QString &usage);
+    QLabel* getHealthLabel() const;
+    void setHealth(HealthState state, const QString &details);
+    HealthState getHealth() const;
+    void updateFlagState(const QString flag, const Qt::CheckState state);
+    QVector<int> getPids(const ProcessTree &processTree) const;
     QString getPIDByPorts() const;
+    int getLaunchSessionId() const;
+    void setLaunchSessionId(int sessionId);
 
 public slots:
     void updateEnabledFlagsLabel();
 
 private:
-    bool isServiceRunning() const;
-    bool checkDebug() const;
-    QString readApplicationShortNameFromFile(const QString& filePath) const;
+    static QVector<int> findPids(const QString &processName, int sessionId, const ProcessTree &processTree);
+    static bool checkDebug(const QString &serviceName, const QVector<int> &servicePorts);
     QString getFolderInfo() const;
-    QVector<int> readPortsFromFile(const QString directory) const;
+    void updateCheckBoxText();
+    void updateStatusCheckBox();
+    void updateProcessMetrics(const ProcessTree &processTree) const;
+    QCheckBox* createFlagCheckBox(const QString &flag);
+    void setFlagEnabled(const QString &flag, bool enabled);
 
     const QString name;
-    const QString shortName;
+    const QString folderName;
+    const QString directory;
+    QString shortName;
     MicroserviceStatus status;
     QCheckBox* checkBox;
     QCheckBox* statusCheckBox;
-    const QVector<int> ports;
+    QVector<int> ports;
+    QString healthEndpoint;
+    QStringList dependencies;
+    QStringList tags;
+    int launchSessionId;
+    QVector<int> lastPids;
+    // Flag state is plain data; checkboxes exist only while the flag control panel shows this row
+    QStringList flagNames;
+    QSet<QString> enabledFlags;
     QVector<QCheckBox*> flagCheckBoxes;
+    bool flagsVisible;
     QHBoxLayout *flagsLayout;
     QVBoxLayout *microserviceLayout;
     QLabel *enabledFlagsLabel;
+    QLabel *supervisionLabel;
+    QLabel *resourceLabel;
+    QLabel *healthLabel;
+    HealthState health;
 };
 
 #endif // MICROSERVICE_DATA_H
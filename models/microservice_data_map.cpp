@@ -1,9 +1,11 @@
 #include "microservice_data_map.h"
+#include "utils/tracer.h"
 
-MicroserviceDataMap::MicroserviceDataMap(const QStringList serviceNames, const QString directory) {
-    for (const QString &name : serviceNames) {
-        MicroserviceData *microservice = new MicroserviceData(name, directory);
-        dataMap.insert(name, microservice);
+MicroserviceDataMap::MicroserviceDataMap(const QVector<ServiceInfo> &services) {
+    TraceSpan span("MicroserviceDataMap::MicroserviceDataMap", "discovery");
+    for (const ServiceInfo &info : services) {
+        MicroserviceData *microservice = new MicroserviceData(info);
+        dataMap.insert(info.name, microservice);
     }
 }
 
@@ -44,3 +46,11 @@ const QMap<QString, MicroserviceData*>& MicroserviceDataMap::getDataMap() const
 bool MicroserviceDataMap::contains(const QString& key) const {
     return dataMap.contains(key);
 }
+
+void MicroserviceDataMap::insert(MicroserviceData* microservice) {
+    dataMap.insert(microservice->getName(), microservice);
+}
+
+MicroserviceData* MicroserviceDataMap::take(const QString& key) {
+    return dataMap.take(key);
+}
@@ -5,12 +5,14 @@
 
 class MicroserviceDataMap {
 public:
-    MicroserviceDataMap(const QStringList serviceNames, const QString directory);
+    explicit MicroserviceDataMap(const QVector<ServiceInfo> &services);
     MicroserviceData* value(const QString& key) const;
     QVector<MicroserviceData*> getCheckedServices();
     QVector<MicroserviceData*> getServicesByStatus(const MicroserviceStatus& status) const;
     const QMap<QString, MicroserviceData*>& getDataMap() const;
     bool contains(const QString& key) const;
+    void insert(MicroserviceData* microservice);
+    MicroserviceData* take(const QString& key);
 
 private:
     QMap<QString, MicroserviceData*> dataMap;
@@ -1,10 +1,62 @@
 #ifndef MICROSERVICE_STATUS_H
 #define MICROSERVICE_STATUS_H
 
+#include <QString>
+
 enum class MicroserviceStatus {
     Active,
     Debug,
     Inactive
 };
 
+inline QString microserviceStatusToString(const MicroserviceStatus status) {
+    switch (status) {
+    case MicroserviceStatus::Active:
+        return "Active";
+    case MicroserviceStatus::Debug:
+        return "Debug";
+    case MicroserviceStatus::Inactive:
+        return "Inactive";
+    }
+
+    return QString();
+}
+
+inline bool microserviceStatusFromString(const QString &text, MicroserviceStatus &status) {
+    const QString trimmed = text.trimmed();
+    if (trimmed.compare("Active", Qt::CaseInsensitive) == 0) {
+        status = MicroserviceStatus::Active;
+    } else if (trimmed.compare("Debug", Qt::CaseInsensitive) == 0) {
+        status = MicroserviceStatus::Debug;
+    } else if (trimmed.compare("Inactive", Qt::CaseInsensitive) == 0) {
+        status = MicroserviceStatus::Inactive;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+enum class HealthState {
+    Unknown,
+    Healthy,
+    Degraded,
+    Down
+};
+
+inline QString healthStateToString(const HealthState state) {
+    switch (state) {
+    case HealthState::Unknown:
+        return "Unknown";
+    case HealthState::Healthy:
+        return "Healthy";
+    case HealthState::Degraded:
+        return "Degraded";
+    case HealthState::Down:
+        return "Down";
+    }
+
+    return QString();
+}
+
 #endif // MICROSERVICE_STATUS_H
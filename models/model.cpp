@@ -1,5 +1,7 @@
 #include "model.h"
 #include "microservice_data.h"
+#include "utils/tracer.h"
+#include "service_discovery.h"
 
 #include <QDir>
 #include <QMessageBox>
@@ -7,13 +9,20 @@
 #include <QSettings>
 #include <QCoreApplication>
 #include <QStandardPaths>
+#include <QRegularExpression>
+#include <QSet>
 
 Model::Model()
     : defaultConfigFile(createEmptyFile("/config.ini"))
     , defaultSaveFile(createEmptyFile("/save.ini"))
-    , directory(findDirectory())
+    , snapshotFile(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/snapshot.json")
+    , configuredDirectories(readDirectories())
+    , excludedFolders(readExcludedFoldersFromConfig())
+    , snapshot(readSnapshot())
+    , stale(!snapshot.services.isEmpty())
+    , directories(findDirectories())
     , defaultButtonStyle(readDefaultButtonStyle())
-    , microservices(getFolderNames(), directory)
+    , microservices(stale ? snapshot.services : ServiceDiscovery::discover(directories, excludedFolders))
     , flagNames(loadFlagNames())
 {}
 
@@ -21,25 +30,60 @@ QString Model::getConfigFile() const {
     return defaultConfigFile;
 }
 
-QString Model::findDirectory() const {
-    QString directory = readDirectory();
-
-    QProcess process;
-    process.start("sh", QStringList() << "-c" << "echo " + directory);
-    process.waitForFinished(-1);
-    directory = process.readAllStandardOutput().trimmed();
+QStringList Model::findDirectories() const {
+    TraceSpan span("Model::findDirectories", "startup");
+    if (stale) {
+        return snapshot.directories;
+    }
 
-    QDir initialDir(directory);
-    if (directory.isEmpty() || !initialDir.exists()) {
-        QMessageBox::critical(nullptr, "Error", "Directory " + directory + " does not exist or is empty.");
+    if (configuredDirectories.isEmpty()) {
+        QMessageBox::critical(nullptr, "Error", "Directory is not set.");
         exit(EXIT_FAILURE);
     }
 
-    qDebug() << "initialDir: " << directory;
-    return directory;
+    QStringList directories;
+    for (auto iter = configuredDirectories.constBegin(); iter != configuredDirectories.constEnd(); ++iter) {
+        QString directory = QDir::cleanPath(expandPath(iter->trimmed()));
+
+        QDir initialDir(directory);
+        if (directory.isEmpty() || !initialDir.exists()) {
+            QMessageBox::critical(nullptr, "Error", "Directory " + directory + " does not exist or is empty.");
+            exit(EXIT_FAILURE);
+        }
+
+        if (!directories.contains(directory)) {
+            directories.append(directory);
+        }
+    }
+
+    qDebug() << "initialDirs: " << directories;
+    return directories;
+}
+
+// Expands ~ and environment variables ($NAME, ${NAME}) like the shell does for "echo <path>"
+QString Model::expandPath(const QString &path) {
+    QString expanded = path;
+    if (expanded == "~" || expanded.startsWith("~/")) {
+        expanded.replace(0, 1, QDir::homePath());
+    }
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    static const QRegularExpression variable("\\$(?:\\{([A-Za-z_][A-Za-z0-9_]*)\\}|([A-Za-z_][A-Za-z0-9_]*))");
+    QString result;
+    int position = 0;
+    QRegularExpressionMatchIterator matches = variable.globalMatch(expanded);
+    while (matches.hasNext()) {
+        QRegularExpressionMatch match = matches.next();
+        QString name = match.captured(1).isEmpty() ? match.captured(2) : match.captured(1);
+        result += expanded.mid(position, match.capturedStart() - position) + environment.value(name);
+        position = match.capturedEnd();
+    }
+
+    return result + expanded.mid(position);
 }
 
 QString Model::readDefaultButtonStyle() const {
+    TraceSpan span("Model::readDefaultButtonStyle", "config");
     QSettings settings(defaultConfigFile, QSettings::IniFormat);
 
     settings.beginGroup("Main");
@@ -55,25 +99,94 @@ QString Model::readDefaultButtonStyle() const {
     return buttonStyle;
 }
 
-QStringList Model::getFolderNames() const {
-    QStringList folderNames;
-    QDir dir(directory);
+// Roots are joined like PATH for scripts that are executed once for all services
+QString Model::getDirectory() const {
+    // Scripts receive one path as their directory argument; all roots are passed in MICROSERVICE_LAUNCHER_DIRECTORIES
+    return directories.value(0);
+}
+
+QStringList Model::getDirectories() const {
+    return directories;
+}
+
+QStringList Model::getExcludedFolders() const {
+    return excludedFolders;
+}
+
+bool Model::isStale() const {
+    return stale;
+}
+
+// The snapshot is only used while the configuration it was discovered with is unchanged
+ServiceSnapshot Model::readSnapshot() const {
+    ServiceSnapshot saved;
+    if (!ServiceSnapshot::read(snapshotFile, saved)) {
+        return ServiceSnapshot();
+    }
 
-    QStringList folderList = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-    QStringList excludedFolders = readExcludedFoldersFromConfig();
+    if (saved.configuredDirectories != configuredDirectories || saved.excludedFolders != excludedFolders) {
+        qDebug() << "Configuration changed since the last snapshot, discovering services";
+        return ServiceSnapshot();
+    }
 
-    for (auto iter = folderList.constBegin(); iter != folderList.constEnd(); ++iter) {
-        if (!excludedFolders.contains(*iter)) {
-            folderNames.append(*iter);
+    for (auto iter = saved.directories.constBegin(); iter != saved.directories.constEnd(); ++iter) {
+        if (!QDir(*iter).exists()) {
+            return ServiceSnapshot();
         }
     }
 
-    folderNames.sort();
-    return folderNames;
+    return saved;
 }
 
-QString Model::getDirectory() const {
-    return directory;
+void Model::saveSnapshot() const {
+    ServiceSnapshot current;
+    current.configuredDirectories = configuredDirectories;
+    current.directories = directories;
+    current.excludedFolders = excludedFolders;
+
+    QMap<QString, MicroserviceData*> microservicesMap = microservices.getDataMap();
+    for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        current.services.append(iter.value()->getServiceInfo());
+    }
+
+    current.write(snapshotFile);
+}
+
+ServiceChanges Model::merge(const QVector<ServiceInfo> &services) {
+    // Adds and updates services without removing any, e.g. for partial discovery results
+    ServiceChanges changes;
+    for (auto iter = services.constBegin(); iter != services.constEnd(); ++iter) {
+        MicroserviceData *microservice = microservices.value(iter->name);
+        if (!microservice) {
+            microservice = new MicroserviceData(*iter);
+            microservices.insert(microservice);
+            changes.added.append(microservice);
+        } else if (microservice->updateServiceInfo(*iter)) {
+            changes.updated.append(microservice);
+        }
+    }
+
+    return changes;
+}
+
+ServiceChanges Model::reconcile(const QVector<ServiceInfo> &services, const std::function<bool(MicroserviceData*)> &canRemove) {
+    TraceSpan span("Model::reconcile", "discovery");
+    ServiceChanges changes = merge(services);
+
+    QSet<QString> discoveredNames;
+    for (auto iter = services.constBegin(); iter != services.constEnd(); ++iter) {
+        discoveredNames.insert(iter->name);
+    }
+
+    QStringList currentNames = microservices.getDataMap().keys();
+    for (auto iter = currentNames.constBegin(); iter != currentNames.constEnd(); ++iter) {
+        if (!discoveredNames.contains(*iter) && canRemove(microservices.value(*iter))) {
+            changes.removed.append(microservices.take(*iter));
+        }
+    }
+
+    stale = false;
+    return changes;
 }
 
 QString Model::createEmptyFile(const QString fileName) const {
@@ -104,23 +217,26 @@ QString Model::createEmptyFile(const QString fileName) const {
     return filePath;
 }
 
-QString Model::readDirectory() const {
+QStringList Model::readDirectories() const {
+    TraceSpan span("Model::readDirectories", "config");
     QSettings settings(defaultConfigFile, QSettings::IniFormat);
 
     settings.beginGroup("Main");
 
     if (!settings.contains("Directory")) {
-        return "";
+        return QStringList();
     }
 
-    QString directory = settings.value("Directory").toString();
+    QStringList directories = settings.value("Directory").toStringList();
+    directories.removeAll(QString());
 
     settings.endGroup();
 
-    return directory;
+    return directories;
 }
 
 QStringList Model::readExcludedFoldersFromConfig() const {
+    TraceSpan span("Model::readExcludedFoldersFromConfig", "config");
     QSettings settings(defaultConfigFile, QSettings::IniFormat);
 
     settings.beginGroup("Main");
@@ -144,6 +260,7 @@ QString Model::getSaveFile() const {
 }
 
 QStringList Model::loadFlagNames() {
+    TraceSpan span("Model::loadFlagNames", "config");
     QSettings settings(getSaveFile(), QSettings::IniFormat);
     QStringList names;
 
@@ -3,6 +3,16 @@
 
 #include <QtWidgets/qcheckbox.h>
 #include "microservice_data_map.h"
+#include "service_snapshot.h"
+
+#include <functional>
+
+// Result of merging a new discovery into the current service list
+struct ServiceChanges {
+    QVector<MicroserviceData*> added;
+    QVector<MicroserviceData*> updated;
+    QVector<MicroserviceData*> removed; // no longer in the list, to be deleted by the caller
+};
 
 class Model
 {
@@ -11,23 +21,35 @@ public:
     QString getConfigFile() const;
     MicroserviceDataMap getMicroservices() const;
     QString getDirectory() const;
+    QStringList getDirectories() const;
+    QStringList getExcludedFolders() const;
+    bool isStale() const;
+    ServiceChanges merge(const QVector<ServiceInfo> &services);
+    ServiceChanges reconcile(const QVector<ServiceInfo> &services, const std::function<bool(MicroserviceData*)> &canRemove);
+    void saveSnapshot() const;
     QString getSaveFile() const;
     QStringList getFlagNames() const;
     QString getDefaultButtonStyle() const;
     void addFlagName(const QString& flagName);
 
 private:
-    QString readDirectory() const;
+    QStringList readDirectories() const;
     QString readDefaultButtonStyle() const;
     QStringList readExcludedFoldersFromConfig() const;
     QString createEmptyFile(const QString fileName) const;
-    QString findDirectory() const;
-    QStringList getFolderNames() const;
+    QStringList findDirectories() const;
+    static QString expandPath(const QString &path);
+    ServiceSnapshot readSnapshot() const;
     QStringList loadFlagNames();
 
     const QString defaultConfigFile;
     const QString defaultSaveFile;
-    const QString directory;
+    const QString snapshotFile;
+    const QStringList configuredDirectories;
+    const QStringList excludedFolders;
+    const ServiceSnapshot snapshot;
+    bool stale;
+    const QStringList directories;
     const QString defaultButtonStyle;
 
     MicroserviceDataMap microservices;
@@ -0,0 +1,214 @@
+#include "port_registry.h"
+#include "utils/tracer.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSet>
+
+namespace {
+const int lsofTimeoutMs = 5000;
+}
+
+QString PortConflict::describe() const {
+    if (!otherServiceName.isEmpty()) {
+        return QString("%1: port %2 is also used by %3").arg(serviceName).arg(port).arg(otherServiceName);
+    }
+
+    return QString("%1: port %2 is in use by %3 (PID %4)").arg(serviceName).arg(port).arg(processName).arg(pid);
+}
+
+PortRegistry::PortRegistry(const MicroserviceDataMap &microservices, const ProcessTree &processTree)
+    : processTree(processTree)
+{
+    TraceSpan span("PortRegistry::PortRegistry", "status");
+
+    const QMap<QString, MicroserviceData*> &dataMap = microservices.getDataMap();
+    for (auto iter = dataMap.constBegin(); iter != dataMap.constEnd(); ++iter) {
+        foreach (int port, iter.value()->getPorts()) {
+            declaredPorts[port].append(iter.value());
+        }
+    }
+
+    readListeningSockets();
+}
+
+PortRegistry::PortRegistry(const ProcessTree &processTree)
+    : processTree(processTree)
+{}
+
+// Only the given ports are resolved, so the process list is not needed
+int PortRegistry::findListenerPid(const QVector<int> &ports) {
+    TraceSpan span("PortRegistry::findListenerPid", "status");
+    static const ProcessTree noProcesses;
+
+    PortRegistry registry(noProcesses);
+    foreach (int port, ports) {
+        registry.declaredPorts.insert(port, QVector<MicroserviceData*>());
+    }
+    registry.readListeningSockets();
+
+    foreach (int port, ports) {
+        if (registry.listeners.value(port).pid > 0) {
+            return registry.listeners.value(port).pid;
+        }
+    }
+
+    return 0;
+}
+
+void PortRegistry::readListeningSockets() {
+#if defined(Q_OS_LINUX)
+    QHash<quint64, int> inodePorts;
+    readProcNet("/proc/net/tcp", inodePorts);
+    readProcNet("/proc/net/tcp6", inodePorts);
+
+    // Only sockets on declared ports are resolved to their owning process
+    for (auto iter = inodePorts.constBegin(); iter != inodePorts.constEnd(); ++iter) {
+        PortListener listener;
+        listener.port = iter.value();
+        listeners.insert(listener.port, listener);
+    }
+
+    if (inodePorts.isEmpty()) {
+        return;
+    }
+
+    QStringList pidEntries = QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (auto pidIter = pidEntries.constBegin(); pidIter != pidEntries.constEnd() && !inodePorts.isEmpty(); ++pidIter) {
+        bool ok;
+        int pid = pidIter->toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+
+        QDir fdDir("/proc/" + *pidIter + "/fd");
+        QStringList fds = fdDir.entryList(QDir::System | QDir::NoDotAndDotDot);
+        for (auto fdIter = fds.constBegin(); fdIter != fds.constEnd(); ++fdIter) {
+            QString target = QFileInfo(fdDir.filePath(*fdIter)).symLinkTarget();
+            if (!target.contains("socket:[")) {
+                continue;
+            }
+
+            quint64 inode = target.section('[', 1).chopped(1).toULongLong();
+            if (inodePorts.contains(inode)) {
+                PortListener &listener = listeners[inodePorts.take(inode)];
+                listener.pid = pid;
+                listener.processName = processTree.value(pid).name;
+            }
+        }
+    }
+#else
+    // One lsof call lists every listening TCP socket together with its process; it answers within
+    // milliseconds, so it is run directly and given up after a few seconds
+    QProcess lsof;
+    lsof.start("lsof", QStringList() << "-nP" << "-iTCP" << "-sTCP:LISTEN" << "-Fpcn");
+    if (!lsof.waitForStarted() || !lsof.waitForFinished(lsofTimeoutMs)) {
+        qWarning() << "Failed to list listening sockets:" << lsof.errorString();
+        lsof.kill();
+        return;
+    }
+
+    PortListener current;
+    foreach (const QByteArray &line, lsof.readAllStandardOutput().split('\n')) {
+        if (line.startsWith('p')) {
+            current.pid = line.mid(1).toInt();
+        } else if (line.startsWith('c')) {
+            current.processName = QString::fromLocal8Bit(line.mid(1));
+        } else if (line.startsWith('n')) {
+            int port = line.mid(line.lastIndexOf(':') + 1).toInt();
+            if (declaredPorts.contains(port)) {
+                current.port = port;
+                listeners.insert(port, current);
+            }
+        }
+    }
+#endif
+}
+
+void PortRegistry::readProcNet(const QString &fileName, QHash<quint64, int> &inodePorts) const {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    file.readLine(); // Header
+    while (!file.atEnd()) {
+        // sl local_address rem_address st tx_queue:rx_queue tr:tm->when retrnsmt uid timeout inode
+        QList<QByteArray> fields = file.readLine().simplified().split(' ');
+        if (fields.size() < 10 || fields.at(3) != "0A") {
+            continue; // Not listening
+        }
+
+        bool ok;
+        int port = fields.at(1).mid(fields.at(1).indexOf(':') + 1).toInt(&ok, 16);
+        if (ok && declaredPorts.contains(port)) {
+            inodePorts.insert(fields.at(9).toULongLong(), port);
+        }
+    }
+}
+
+QString PortRegistry::findOwner(int port, int pid) const {
+    if (pid <= 0) {
+        return QString();
+    }
+
+    foreach (MicroserviceData *microservice, declaredPorts.value(port)) {
+        if (microservice->getPids(processTree).contains(pid)) {
+            return microservice->getName();
+        }
+    }
+
+    return QString();
+}
+
+QVector<PortConflict> PortRegistry::findConflicts(const QVector<MicroserviceData*> &servicesToStart) const {
+    TraceSpan span("PortRegistry::findConflicts", "status");
+    QVector<PortConflict> conflicts;
+    QSet<MicroserviceData*> startingServices(servicesToStart.constBegin(), servicesToStart.constEnd());
+
+    for (auto serviceIter = servicesToStart.constBegin(); serviceIter != servicesToStart.constEnd(); ++serviceIter) {
+        MicroserviceData *microservice = *serviceIter;
+
+        foreach (int port, microservice->getPorts()) {
+            bool reported = false;
+
+            // Another service declaring the same port that is running or started in the same batch
+            foreach (MicroserviceData *other, declaredPorts.value(port)) {
+                if (other == microservice) {
+                    continue;
+                }
+
+                if (startingServices.contains(other) || other->getStatus() != MicroserviceStatus::Inactive) {
+                    PortConflict conflict;
+                    conflict.serviceName = microservice->getName();
+                    conflict.port = port;
+                    conflict.otherServiceName = other->getName();
+                    conflicts.append(conflict);
+                    reported = true;
+                }
+            }
+
+            if (reported || !listeners.contains(port)) {
+                continue;
+            }
+
+            // A listening socket that does not belong to the service itself
+            const PortListener listener = listeners.value(port);
+            if (listener.pid > 0 && microservice->getPids(processTree).contains(listener.pid)) {
+                continue;
+            }
+
+            PortConflict conflict;
+            conflict.serviceName = microservice->getName();
+            conflict.port = port;
+            conflict.otherServiceName = findOwner(port, listener.pid);
+            conflict.pid = listener.pid;
+            conflict.processName = listener.processName.isEmpty() ? "unknown process" : listener.processName;
+            conflicts.append(conflict);
+        }
+    }
+
+    return conflicts;
+}
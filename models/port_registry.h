@@ -0,0 +1,43 @@
+#ifndef PORT_REGISTRY_H
+#define PORT_REGISTRY_H
+
+#include "microservice_data_map.h"
+#include "process_tree.h"
+
+#include <QHash>
+
+struct PortListener {
+    int port = 0;
+    int pid = 0;
+    QString processName;
+};
+
+struct PortConflict {
+    QString serviceName;
+    int port = 0;
+    QString otherServiceName; // Empty if the port is used by a process of no known service
+    int pid = 0;
+    QString processName;
+
+    QString describe() const;
+};
+
+// Index of the ports declared by every service and of the ports currently listening.
+class PortRegistry {
+public:
+    PortRegistry(const MicroserviceDataMap &microservices, const ProcessTree &processTree);
+    QVector<PortConflict> findConflicts(const QVector<MicroserviceData*> &servicesToStart) const;
+    static int findListenerPid(const QVector<int> &ports);
+
+private:
+    explicit PortRegistry(const ProcessTree &processTree);
+    void readListeningSockets();
+    void readProcNet(const QString &fileName, QHash<quint64, int> &inodePorts) const;
+    QString findOwner(int port, int pid) const;
+
+    const ProcessTree &processTree;
+    QHash<int, QVector<MicroserviceData*>> declaredPorts;
+    QHash<int, PortListener> listeners;
+};
+
+#endif // PORT_REGISTRY_H
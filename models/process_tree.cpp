@@ -0,0 +1,259 @@
+#include "process_tree.h"
+#include "utils/tracer.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QSet>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+ProcessTree ProcessTree::snapshot() {
+    TraceSpan span("ProcessTree::snapshot", "status");
+
+#if defined(Q_OS_LINUX)
+    return readProc();
+#else
+    return readPs();
+#endif
+}
+
+// Start times count from boot, so they can only be compared within the boot they were read in
+QString ProcessTree::bootId() {
+#if defined(Q_OS_LINUX)
+    QFile file("/proc/sys/kernel/random/boot_id");
+    if (file.open(QIODevice::ReadOnly)) {
+        return QString::fromLatin1(file.readAll().trimmed());
+    }
+#elif defined(Q_OS_MACOS)
+    QProcess process;
+    process.start("sysctl", QStringList() << "-n" << "kern.bootsessionuuid");
+    if (process.waitForFinished() && process.exitCode() == 0) {
+        return QString::fromLatin1(process.readAllStandardOutput().trimmed());
+    }
+#endif
+    return QString();
+}
+
+ProcessTree ProcessTree::readProc() {
+    ProcessTree tree;
+#if defined(Q_OS_LINUX)
+    const qint64 ticksPerSecond = ::sysconf(_SC_CLK_TCK);
+    const qint64 pageSize = ::sysconf(_SC_PAGESIZE);
+#else
+    const qint64 ticksPerSecond = 100;
+    const qint64 pageSize = 4096;
+#endif
+
+    QDir procDir("/proc");
+    QStringList entries = procDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (auto iter = entries.constBegin(); iter != entries.constEnd(); ++iter) {
+        bool ok;
+        int pid = iter->toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+
+        QFile statFile("/proc/" + *iter + "/stat");
+        if (!statFile.open(QIODevice::ReadOnly)) {
+            continue; // Process exited while reading
+        }
+
+        // Format: pid (comm) state ppid pgrp session ...; comm may contain spaces and parentheses.
+        QByteArray stat = statFile.readAll();
+        int nameStart = stat.indexOf('(');
+        int nameEnd = stat.lastIndexOf(')');
+        if (nameStart == -1 || nameEnd == -1) {
+            continue;
+        }
+
+        QList<QByteArray> fields = stat.mid(nameEnd + 2).split(' ');
+        if (fields.size() < 22) {
+            continue;
+        }
+
+        ProcessInfo info;
+        info.pid = pid;
+        info.name = QString::fromLocal8Bit(stat.mid(nameStart + 1, nameEnd - nameStart - 1));
+        info.parentPid = fields.at(1).toInt();
+        info.processGroupId = fields.at(2).toInt();
+        info.sessionId = fields.at(3).toInt();
+        info.cpuTimeMs = (fields.at(11).toLongLong() + fields.at(12).toLongLong()) * 1000 / qMax<qint64>(1, ticksPerSecond);
+        info.residentBytes = fields.at(21).toLongLong() * pageSize;
+        info.startTime = fields.at(19).toLongLong();
+        tree.insert(info);
+    }
+
+    return tree;
+}
+
+ProcessTree ProcessTree::readPs() {
+    ProcessTree tree;
+
+    // ps does not expose session ids on macOS, so the process group is used to track launched services.
+    // lstart is printed as "Sat Oct 18 09:05:02 2026"; the C locale keeps the names English
+    QProcess process;
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("LC_ALL", "C");
+    process.setProcessEnvironment(environment);
+    process.start("ps", QStringList() << "-axo" << "pid=,ppid=,pgid=,rss=,time=,lstart=,comm=");
+    if (!process.waitForStarted() || !process.waitForFinished()) {
+        qWarning() << "Failed to list processes:" << process.errorString();
+        return tree;
+    }
+
+    QStringList lines = QString::fromLocal8Bit(process.readAllStandardOutput()).split('\n', Qt::SkipEmptyParts);
+    for (auto iter = lines.constBegin(); iter != lines.constEnd(); ++iter) {
+        QStringList fields = iter->trimmed().split(' ', Qt::SkipEmptyParts);
+        if (fields.size() < 11) {
+            continue;
+        }
+
+        ProcessInfo info;
+        info.pid = fields.at(0).toInt();
+        info.parentPid = fields.at(1).toInt();
+        info.processGroupId = fields.at(2).toInt();
+        info.sessionId = info.processGroupId;
+        info.residentBytes = fields.at(3).toLongLong() * 1024;
+        info.cpuTimeMs = parsePsTime(fields.at(4));
+        QDateTime started = QDateTime::fromString(fields.mid(5, 5).join(' '), "ddd MMM d hh:mm:ss yyyy");
+        info.startTime = started.isValid() ? started.toSecsSinceEpoch() : 0;
+        info.name = QDir(fields.mid(10).join(' ')).dirName();
+        tree.insert(info);
+    }
+
+    return tree;
+}
+
+// ps prints CPU time as [[dd-]hh:]mm:ss[.ss]
+qint64 ProcessTree::parsePsTime(const QString &time) {
+    qint64 days = 0;
+    QString clock = time;
+    int dash = clock.indexOf('-');
+    if (dash != -1) {
+        days = clock.left(dash).toLongLong();
+        clock = clock.mid(dash + 1);
+    }
+
+    double seconds = 0;
+    foreach (const QString &part, clock.split(':')) {
+        seconds = seconds * 60 + part.toDouble();
+    }
+
+    return static_cast<qint64>((days * 86400 + seconds) * 1000);
+}
+
+void ProcessTree::insert(const ProcessInfo &info) {
+    processes.insert(info.pid, info);
+    children.insert(info.parentPid, info.pid);
+}
+
+bool ProcessTree::isEmpty() const {
+    return processes.isEmpty();
+}
+
+bool ProcessTree::contains(int pid) const {
+    return processes.contains(pid);
+}
+
+ProcessInfo ProcessTree::value(int pid) const {
+    return processes.value(pid);
+}
+
+QVector<int> ProcessTree::getPidsByName(const QString &name) const {
+    QVector<int> pids;
+    // The kernel truncates process names to 15 characters, ps -C compares the same way.
+    QString shortName = name.left(15);
+
+    for (auto iter = processes.constBegin(); iter != processes.constEnd(); ++iter) {
+        if (iter->name == name || iter->name == shortName) {
+            pids.append(iter->pid);
+        }
+    }
+
+    return pids;
+}
+
+QVector<int> ProcessTree::getPidsInSession(int sessionId) const {
+    QVector<int> pids;
+    if (sessionId <= 0) {
+        return pids;
+    }
+
+    QSet<int> seen;
+    for (auto iter = processes.constBegin(); iter != processes.constEnd(); ++iter) {
+        if (iter->sessionId != sessionId || seen.contains(iter->pid)) {
+            continue;
+        }
+
+        seen.insert(iter->pid);
+        pids.append(iter->pid);
+
+        // Children that started their own session are still part of the launched service.
+        foreach (int child, getDescendants(iter->pid)) {
+            if (!seen.contains(child)) {
+                seen.insert(child);
+                pids.append(child);
+            }
+        }
+    }
+
+    return pids;
+}
+
+qint64 ProcessTree::getLastStartInSession(int sessionId) const {
+    qint64 lastStart = 0;
+    for (auto iter = processes.constBegin(); iter != processes.constEnd(); ++iter) {
+        if (iter->sessionId == sessionId) {
+            lastStart = qMax(lastStart, iter->startTime);
+        }
+    }
+
+    return lastStart;
+}
+
+// A session id is only reused once every process of the old session is gone, so a process that
+// started by the given time proves the session is still the one seen then.
+bool ProcessTree::hasStartedInSessionBy(int sessionId, qint64 startTime) const {
+    for (auto iter = processes.constBegin(); iter != processes.constEnd(); ++iter) {
+        if (iter->sessionId == sessionId && iter->startTime <= startTime) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QVector<int> ProcessTree::getDescendants(int pid) const {
+    QVector<int> descendants;
+    QSet<int> seen;
+    QVector<int> queue = children.values(pid);
+
+    while (!queue.isEmpty()) {
+        int child = queue.takeLast();
+        if (child == pid || seen.contains(child)) {
+            continue;
+        }
+
+        seen.insert(child);
+        descendants.append(child);
+        queue.append(children.values(child));
+    }
+
+    return descendants;
+}
+
+QVector<int> ProcessTree::getProcessGroups(const QVector<int> &pids) const {
+    QVector<int> processGroups;
+    for (int pid : pids) {
+        int processGroupId = processes.value(pid).processGroupId;
+        if (processGroupId > 1 && !processGroups.contains(processGroupId)) {
+            processGroups.append(processGroupId);
+        }
+    }
+
+    return processGroups;
+}
@@ -0,0 +1,45 @@
+#ifndef PROCESS_TREE_H
+#define PROCESS_TREE_H
+
+#include <QHash>
+#include <QMultiHash>
+#include <QString>
+#include <QVector>
+
+struct ProcessInfo {
+    int pid = 0;
+    int parentPid = 0;
+    int processGroupId = 0;
+    int sessionId = 0;
+    qint64 cpuTimeMs = 0;
+    qint64 residentBytes = 0;
+    qint64 startTime = 0; // clock ticks after boot (Linux) or seconds since the epoch (ps), 0 where unknown
+    QString name;
+};
+
+// Snapshot of all processes of the system, read once and queried for many services.
+class ProcessTree {
+public:
+    static ProcessTree snapshot();
+    static QString bootId();
+    bool isEmpty() const;
+    bool contains(int pid) const;
+    ProcessInfo value(int pid) const;
+    QVector<int> getPidsByName(const QString &name) const;
+    QVector<int> getPidsInSession(int sessionId) const;
+    qint64 getLastStartInSession(int sessionId) const;
+    bool hasStartedInSessionBy(int sessionId, qint64 startTime) const;
+    QVector<int> getDescendants(int pid) const;
+    QVector<int> getProcessGroups(const QVector<int> &pids) const;
+
+private:
+    void insert(const ProcessInfo &info);
+    static qint64 parsePsTime(const QString &time);
+    static ProcessTree readProc();
+    static ProcessTree readPs();
+
+    QHash<int, ProcessInfo> processes;
+    QMultiHash<int, int> children;
+};
+
+#endif // PROCESS_TREE_H
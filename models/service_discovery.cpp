@@ -0,0 +1,342 @@
+#include "service_discovery.h"
+#include "utils/tracer.h"
+#include "utils/metrics.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSet>
+#include <QStandardPaths>
+#include <QtConcurrent/QtConcurrent>
+
+QVector<ServiceInfo> ServiceDiscovery::discover(const QStringList &directories, const QStringList &excludedFolders, const ServiceCallback &onDiscovered) {
+    TraceSpan span("ServiceDiscovery::discover", "discovery");
+    QElapsedTimer timer;
+    timer.start();
+
+    QDir appData(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    Scripts scripts;
+    if (QFileInfo(appData.filePath("discover_all.sh")).isExecutable()) {
+        scripts.discoverAll = appData.filePath("discover_all.sh");
+    }
+    if (QFileInfo(appData.filePath("service_info.sh")).isExecutable()) {
+        scripts.serviceInfo = appData.filePath("service_info.sh");
+    }
+
+    // Names of services of several roots are only final after assignUniqueNames, so they are not reported early
+    ServiceCallback callback = directories.size() == 1 ? onDiscovered : ServiceCallback();
+
+    // Roots are independent, so startup takes as long as the slowest root instead of all of them together
+    QList<QVector<ServiceInfo>> discovered = QtConcurrent::blockingMapped<QList<QVector<ServiceInfo>>>(
+        directories,
+        [&excludedFolders, &scripts, &callback](const QString &directory) {
+            return discoverDirectory(directory, excludedFolders, scripts, callback);
+        });
+
+    QVector<ServiceInfo> services;
+    for (auto iter = discovered.constBegin(); iter != discovered.constEnd(); ++iter) {
+        services += *iter;
+    }
+
+    assignUniqueNames(services);
+
+    Metrics::instance().setGauge("launcher_discovery_duration_seconds", {}, timer.elapsed() / 1000.0);
+    Metrics::instance().setGauge("launcher_discovered_services", {}, services.size());
+    return services;
+}
+
+QVector<ServiceInfo> ServiceDiscovery::discoverDirectory(const QString &directory, const QStringList &excludedFolders, const Scripts &scripts, const ServiceCallback &onDiscovered) {
+    TraceSpan span("ServiceDiscovery::discoverDirectory", "discovery", directory);
+    QElapsedTimer timer;
+    timer.start();
+    QVector<ServiceInfo> services;
+    QDir dir(directory);
+
+    // Excluded folders are given either by name (excluded in every root) or by full path
+    QStringList folderList;
+    foreach (const QString &folder, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        if (!excludedFolders.contains(folder) && !excludedFolders.contains(dir.filePath(folder))) {
+            folderList.append(folder);
+        }
+    }
+
+    QHash<QString, ServiceInfo> reported;
+    if (!scripts.discoverAll.isEmpty() && !folderList.isEmpty()) {
+        reported = discoverAll(scripts.discoverAll, directory, folderList, onDiscovered);
+    }
+
+    for (auto iter = folderList.constBegin(); iter != folderList.constEnd(); ++iter) {
+        if (reported.contains(*iter)) {
+            services.append(reported.value(*iter));
+            continue;
+        }
+
+        // Folders not reported by discover_all.sh take one process each; the legacy scripts are
+        // used when service_info.sh is missing or fails
+        QString folderPath = dir.filePath(*iter);
+        ServiceInfo info;
+        info.name = *iter;
+        info.folderName = *iter;
+        info.directory = directory;
+        if (scripts.serviceInfo.isEmpty() || !readServiceInfo(scripts.serviceInfo, folderPath, info)) {
+            info.shortName = readShortName(folderPath, *iter);
+            readPorts(folderPath, info);
+        }
+
+        if (onDiscovered) {
+            onDiscovered(info);
+        }
+
+        services.append(info);
+    }
+
+    Metrics::instance().setGauge("launcher_discovery_directory_duration_seconds", {{"directory", directory}}, timer.elapsed() / 1000.0);
+    return services;
+}
+
+QHash<QString, ServiceInfo> ServiceDiscovery::discoverAll(const QString &scriptPath, const QString &directory, const QStringList &folders, const ServiceCallback &onDiscovered) {
+    TraceSpan span("discover_all.sh", "discovery", directory);
+    QHash<QString, ServiceInfo> reported;
+    QSet<QString> expected(folders.constBegin(), folders.constEnd());
+
+    QProcess process;
+    process.start(scriptPath, QStringList() << directory);
+    if (!process.waitForStarted()) {
+        qWarning() << "Failed to execute script:" << process.errorString();
+        return reported;
+    }
+
+    // The folders left after ExcludedFolders are passed on standard input, one per line
+    process.write(folders.join('\n').toUtf8() + '\n');
+    process.closeWriteChannel();
+
+    // Records are handled as they arrive; a script that stays silent for too long is given up on
+    QByteArray buffer;
+    bool running = true;
+    while (running) {
+        running = process.waitForReadyRead(30000);
+        buffer += process.readAllStandardOutput();
+        if (!running) {
+            process.waitForFinished(1000);
+            buffer += process.readAllStandardOutput() + '\n';
+        }
+
+        int newline;
+        while ((newline = buffer.indexOf('\n')) != -1) {
+            QByteArray line = buffer.left(newline).trimmed();
+            buffer.remove(0, newline + 1);
+            if (line.isEmpty()) {
+                continue;
+            }
+
+            ServiceInfo info;
+            info.folderName = QJsonDocument::fromJson(line).object().value("folder").toString();
+            info.name = info.folderName;
+            info.directory = directory;
+            if (!expected.contains(info.folderName) || reported.contains(info.folderName) || !parseServiceInfo(line, info)) {
+                qDebug() << "Output:" << line;
+                continue;
+            }
+
+            reported.insert(info.folderName, info);
+            if (onDiscovered) {
+                onDiscovered(info);
+            }
+        }
+    }
+
+    if (process.state() != QProcess::NotRunning) {
+        qWarning() << "discover_all.sh did not finish for" << directory;
+        process.kill();
+        process.waitForFinished();
+    } else if (process.exitCode() != 0) {
+        qWarning() << "Process failed with exit code:" << process.exitCode() << "Error:" << process.readAllStandardError();
+    }
+
+    qDebug() << "discover_all.sh described" << reported.size() << "of" << folders.size() << "folders in" << directory;
+    return reported;
+}
+
+void ServiceDiscovery::assignUniqueNames(QVector<ServiceInfo> &services) {
+    QHash<QString, int> folderCounts;
+    QHash<QString, QStringList> rootsByLabel;
+    for (auto iter = services.constBegin(); iter != services.constEnd(); ++iter) {
+        folderCounts[iter->folderName]++;
+
+        QString label = QDir(iter->directory).dirName();
+        if (!rootsByLabel.value(label).contains(iter->directory)) {
+            rootsByLabel[label].append(iter->directory);
+        }
+    }
+
+    for (auto iter = services.begin(); iter != services.end(); ++iter) {
+        if (folderCounts.value(iter->folderName) < 2) {
+            continue;
+        }
+
+        // Roots with the same folder name are told apart by their position in Directory
+        QString label = QDir(iter->directory).dirName();
+        QStringList roots = rootsByLabel.value(label);
+        if (roots.size() > 1) {
+            label += "#" + QString::number(roots.indexOf(iter->directory) + 1);
+        }
+
+        iter->name = label + ":" + iter->folderName;
+    }
+}
+
+bool ServiceDiscovery::readServiceInfo(const QString &scriptPath, const QString &folderPath, ServiceInfo &info) {
+    TraceSpan span("service_info.sh", "discovery", info.folderName);
+
+    QProcess process;
+    process.start(scriptPath, QStringList() << folderPath);
+    if (!process.waitForStarted() || !process.waitForFinished()) {
+        qWarning() << "Failed to execute script:" << process.errorString();
+        return false;
+    }
+
+    if (process.exitCode() != 0) {
+        qWarning() << "Process failed with exit code:" << process.exitCode() << "Error:" << process.readAllStandardOutput();
+        return false;
+    }
+
+    if (!parseServiceInfo(process.readAllStandardOutput(), info)) {
+        qWarning() << "Unrecognized output of service_info.sh for" << folderPath;
+        return false;
+    }
+
+    return true;
+}
+
+bool ServiceDiscovery::parseServiceInfo(const QByteArray &output, ServiceInfo &info) {
+    QByteArray trimmed = output.trimmed();
+
+    // Either a JSON object ...
+    if (trimmed.startsWith('{')) {
+        QJsonParseError error;
+        QJsonObject object = QJsonDocument::fromJson(trimmed, &error).object();
+        if (error.error != QJsonParseError::NoError) {
+            return false;
+        }
+
+        info.shortName = object.value("shortName").toString();
+        info.healthEndpoint = object.value("health").toString();
+        info.dependencies = object.value("dependencies").toVariant().toStringList();
+        info.tags = object.value("tags").toVariant().toStringList();
+
+        // Ports are accepted as numbers or as strings
+        foreach (const QJsonValue &port, object.value("ports").toArray()) {
+            int value = port.isString() ? port.toString().toInt() : port.toInt();
+            if (value > 0) {
+                info.ports.append(value);
+            }
+        }
+
+        return true;
+    }
+
+    // ... or key=value lines, with lists separated by spaces or commas
+    bool recognized = false;
+    QList<QByteArray> lines = trimmed.split('\n');
+    for (auto iter = lines.constBegin(); iter != lines.constEnd(); ++iter) {
+        int separator = iter->indexOf('=');
+        if (separator == -1) {
+            continue;
+        }
+
+        QString key = QString::fromUtf8(iter->left(separator).trimmed());
+        QString value = QString::fromUtf8(iter->mid(separator + 1).trimmed());
+        QStringList values = value.split(QRegularExpression("[\\s,]+"), Qt::SkipEmptyParts);
+
+        if (key == "shortName" || key == "short_name") {
+            info.shortName = value;
+        } else if (key == "ports") {
+            foreach (const QString &port, values) {
+                bool ok;
+                int number = port.toInt(&ok);
+                if (ok) {
+                    info.ports.append(number);
+                }
+            }
+        } else if (key == "health") {
+            info.healthEndpoint = value;
+        } else if (key == "dependencies") {
+            info.dependencies = values;
+        } else if (key == "tags") {
+            info.tags = values;
+        } else {
+            continue;
+        }
+
+        recognized = true;
+    }
+
+    return recognized;
+}
+
+QString ServiceDiscovery::readShortName(const QString &folderPath, const QString &name) {
+    TraceSpan span("short_name.sh", "discovery", name);
+    QStringList args;
+    args << folderPath;
+
+    QProcess process;
+    QString scriptPath = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("short_name.sh");
+    process.start(scriptPath, args);
+    if (!process.waitForStarted() || !process.waitForFinished()) {
+        qWarning() << "Failed to execute script:" << process.errorString();
+        return QString();
+    }
+
+    if (process.exitCode() != 0) {
+        qWarning() << "Process failed with exit code:" << process.exitCode() << "Error:" << process.readAllStandardOutput();
+        return QString();
+    }
+
+    QString output = process.readAllStandardOutput().trimmed();
+    return output;
+}
+
+void ServiceDiscovery::readPorts(const QString &folderPath, ServiceInfo &info) {
+    TraceSpan span("ports.sh", "discovery", info.folderName);
+
+    QStringList args;
+    args << folderPath
+         << info.shortName;
+
+    QProcess process;
+    QString scriptPath = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("ports.sh");
+    process.start(scriptPath, args);
+    if (!process.waitForStarted() || !process.waitForFinished()) {
+        qWarning() << "Failed to execute script:" << process.errorString();
+        return;
+    }
+
+    if (process.exitCode() != 0) {
+        qWarning() << "Process failed with exit code:" << process.exitCode() << "Error:" << process.readAllStandardOutput();
+        return;
+    }
+
+    QString output = process.readAllStandardOutput().trimmed();
+
+    QStringList parts = output.split(" ");
+
+    for (auto iter = parts.constBegin(); iter != parts.constEnd(); ++iter) {
+        // A token like health=8080/actuator/health declares the HTTP health endpoint
+        if (iter->startsWith("health=")) {
+            info.healthEndpoint = iter->mid(7);
+            continue;
+        }
+
+        bool ok;
+        int port = iter->toInt(&ok);
+        if (ok) {
+            info.ports.append(port);
+        }
+    }
+}
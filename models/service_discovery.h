@@ -0,0 +1,51 @@
+#ifndef SERVICE_DISCOVERY_H
+#define SERVICE_DISCOVERY_H
+
+#include "microservice_status.h"
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+// Everything known about a service folder before any widget is created for it.
+struct ServiceInfo {
+    QString name;       // unique name in the list, prefixed with its root when the folder name is not unique
+    QString folderName; // folder (and process) name inside the root
+    QString directory;  // root directory containing the folder
+    QString shortName;
+    QVector<int> ports;
+    QString healthEndpoint; // "<port><path>" of the HTTP health endpoint, empty when none is declared
+    QStringList dependencies;
+    QStringList tags;
+    MicroserviceStatus status = MicroserviceStatus::Inactive;
+};
+
+// Called for every service as soon as it is described, from the discovery threads
+typedef std::function<void(const ServiceInfo &info)> ServiceCallback;
+
+// Enumerates the service folders of all roots, one root per thread.
+// A root is described by one discover_all.sh call when it exists; remaining folders by
+// service_info.sh when it exists, otherwise by short_name.sh and ports.sh.
+class ServiceDiscovery {
+public:
+    static QVector<ServiceInfo> discover(const QStringList &directories, const QStringList &excludedFolders, const ServiceCallback &onDiscovered = ServiceCallback());
+    static bool parseServiceInfo(const QByteArray &output, ServiceInfo &info);
+
+private:
+    struct Scripts {
+        QString discoverAll;
+        QString serviceInfo;
+    };
+
+    static QVector<ServiceInfo> discoverDirectory(const QString &directory, const QStringList &excludedFolders, const Scripts &scripts, const ServiceCallback &onDiscovered);
+    static QHash<QString, ServiceInfo> discoverAll(const QString &scriptPath, const QString &directory, const QStringList &folders, const ServiceCallback &onDiscovered);
+    static void assignUniqueNames(QVector<ServiceInfo> &services);
+    static bool readServiceInfo(const QString &scriptPath, const QString &folderPath, ServiceInfo &info);
+    static QString readShortName(const QString &folderPath, const QString &name);
+    static void readPorts(const QString &folderPath, ServiceInfo &info);
+};
+
+#endif // SERVICE_DISCOVERY_H
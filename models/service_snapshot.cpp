@@ -0,0 +1,106 @@
+#include "service_snapshot.h"
+#include "utils/tracer.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace {
+const int snapshotVersion = 1;
+}
+
+bool ServiceSnapshot::read(const QString &fileName, ServiceSnapshot &snapshot) {
+    TraceSpan span("ServiceSnapshot::read", "startup");
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        qWarning() << "Failed to parse snapshot" << fileName << ":" << error.errorString();
+        return false;
+    }
+
+    QJsonObject root = document.object();
+    if (root.value("version").toInt() != snapshotVersion) {
+        return false;
+    }
+
+    snapshot.configuredDirectories = root.value("configuredDirectories").toVariant().toStringList();
+    snapshot.directories = root.value("directories").toVariant().toStringList();
+    snapshot.excludedFolders = root.value("excludedFolders").toVariant().toStringList();
+    snapshot.services.clear();
+
+    QJsonArray services = root.value("services").toArray();
+    for (auto iter = services.constBegin(); iter != services.constEnd(); ++iter) {
+        QJsonObject entry = iter->toObject();
+
+        ServiceInfo info;
+        info.name = entry.value("name").toString();
+        info.folderName = entry.value("folder").toString();
+        info.directory = entry.value("directory").toString();
+        info.shortName = entry.value("shortName").toString();
+        info.healthEndpoint = entry.value("health").toString();
+        info.dependencies = entry.value("dependencies").toVariant().toStringList();
+        info.tags = entry.value("tags").toVariant().toStringList();
+        microserviceStatusFromString(entry.value("status").toString(), info.status);
+
+        foreach (const QJsonValue &port, entry.value("ports").toArray()) {
+            info.ports.append(port.toInt());
+        }
+
+        if (!info.name.isEmpty()) {
+            snapshot.services.append(info);
+        }
+    }
+
+    return true;
+}
+
+bool ServiceSnapshot::write(const QString &fileName) const {
+    QJsonArray servicesArray;
+    for (auto iter = services.constBegin(); iter != services.constEnd(); ++iter) {
+        QJsonArray ports;
+        foreach (int port, iter->ports) {
+            ports.append(port);
+        }
+
+        QJsonObject entry;
+        entry.insert("name", iter->name);
+        entry.insert("folder", iter->folderName);
+        entry.insert("directory", iter->directory);
+        entry.insert("shortName", iter->shortName);
+        entry.insert("ports", ports);
+        if (!iter->healthEndpoint.isEmpty()) {
+            entry.insert("health", iter->healthEndpoint);
+        }
+        if (!iter->dependencies.isEmpty()) {
+            entry.insert("dependencies", QJsonArray::fromStringList(iter->dependencies));
+        }
+        if (!iter->tags.isEmpty()) {
+            entry.insert("tags", QJsonArray::fromStringList(iter->tags));
+        }
+        entry.insert("status", microserviceStatusToString(iter->status));
+        servicesArray.append(entry);
+    }
+
+    QJsonObject root;
+    root.insert("version", snapshotVersion);
+    root.insert("configuredDirectories", QJsonArray::fromStringList(configuredDirectories));
+    root.insert("directories", QJsonArray::fromStringList(directories));
+    root.insert("excludedFolders", QJsonArray::fromStringList(excludedFolders));
+    root.insert("services", servicesArray);
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write snapshot" << fileName << ":" << file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
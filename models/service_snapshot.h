@@ -0,0 +1,17 @@
+#ifndef SERVICE_SNAPSHOT_H
+#define SERVICE_SNAPSHOT_H
+
+#include "service_discovery.h"
+
+// Last known service list, written on exit and shown at the next start while discovery runs again.
+struct ServiceSnapshot {
+    QStringList configuredDirectories;
+    QStringList directories;
+    QStringList excludedFolders;
+    QVector<ServiceInfo> services;
+
+    static bool read(const QString &fileName, ServiceSnapshot &snapshot);
+    bool write(const QString &fileName) const;
+};
+
+#endif // SERVICE_SNAPSHOT_H
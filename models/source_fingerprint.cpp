@@ -0,0 +1,221 @@
+#include "source_fingerprint.h"
+#include "utils/tracer.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+const quint32 cacheMagic = 0x4d4c4650; // "MLFP"
+const quint16 cacheVersion = 1;
+
+// A file written shortly before the cache may be written again within the same timestamp,
+// so its cached hash is not trusted (the "racy" entries of git's index)
+const qint64 racyWindowMs = 2000;
+
+const int gitTimeoutMs = 10000;
+}
+
+const QStringList SourceFingerprint::defaultIgnored = {".git", "node_modules", "build", "target", ".idea", "*.swp", "*~", "*.log", "*.pid", "nohup.out"};
+
+QByteArray SourceFingerprint::compute(const QString &serviceName, const QString &folderPath, const QStringList &ignored) {
+    TraceSpan span("SourceFingerprint::compute", "build", serviceName);
+    QElapsedTimer timer;
+    timer.start();
+
+    QDir dir(folderPath);
+    if (!dir.exists()) {
+        return QByteArray();
+    }
+
+    Walk walk;
+    foreach (const QString &pattern, ignored) {
+        walk.ignored.append(QRegularExpression(QRegularExpression::wildcardToRegularExpression(pattern)));
+    }
+    walk.gitWorkTree = listGitFiles(folderPath, walk);
+
+    QString cacheFile = getCacheFile(serviceName);
+    walk.previous = loadCache(cacheFile);
+
+    QByteArray fingerprint = hashDirectory(dir, QString(), walk);
+
+    walk.current.writtenMs = QDateTime::currentMSecsSinceEpoch();
+    saveCache(cacheFile, walk.current);
+
+    qDebug() << "Fingerprint of" << serviceName << fingerprint.toHex().left(12) << "from" << walk.current.files.size()
+             << "files," << walk.hashedFiles << "hashed, in" << timer.elapsed() << "ms";
+    return fingerprint;
+}
+
+QByteArray SourceFingerprint::hashDirectory(const QDir &dir, const QString &relativePath, Walk &walk) {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+
+    // Entries are sorted by name, so the hash does not depend on the order of the file system
+    const QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden | QDir::NoSymLinks, QDir::Name);
+    for (auto iter = entries.constBegin(); iter != entries.constEnd(); ++iter) {
+        const QString name = iter->fileName();
+        const QString path = relativePath.isEmpty() ? name : relativePath + "/" + name;
+        if (walk.gitWorkTree) {
+            if (!(iter->isDir() ? walk.gitDirectories : walk.gitFiles).contains(path)) {
+                continue;
+            }
+        } else if (isIgnored(name, walk.ignored)) {
+            continue;
+        }
+
+        QByteArray entryHash;
+        char type;
+        if (iter->isDir()) {
+            type = 'd';
+            entryHash = hashDirectory(QDir(iter->filePath()), path, walk);
+        } else {
+            type = 'f';
+            FileEntry entry;
+            entry.size = iter->size();
+            entry.modifiedMs = iter->lastModified().toMSecsSinceEpoch();
+
+            // Unchanged size and modification time reuse the cached content hash
+            const FileEntry cached = walk.previous.files.value(path);
+            if (!cached.hash.isEmpty() && cached.size == entry.size && cached.modifiedMs == entry.modifiedMs
+                && entry.modifiedMs < walk.previous.writtenMs - racyWindowMs) {
+                entry.hash = cached.hash;
+            } else {
+                entry.hash = hashFile(iter->filePath());
+                walk.hashedFiles++;
+            }
+
+            // An unreadable file changes the fingerprint every time, so its service is always built
+            if (entry.hash.isEmpty()) {
+                entry.hash = QByteArray::number(QDateTime::currentMSecsSinceEpoch());
+            } else {
+                walk.current.files.insert(path, entry);
+            }
+            entryHash = entry.hash;
+        }
+
+        hash.addData(QByteArray(1, type));
+        hash.addData(name.toUtf8());
+        hash.addData(QByteArray(1, '\0'));
+        hash.addData(entryHash);
+    }
+
+    return hash.result();
+}
+
+QByteArray SourceFingerprint::hashFile(const QString &filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+
+    return hash.result();
+}
+
+bool SourceFingerprint::listGitFiles(const QString &folderPath, Walk &walk) {
+    // Files added but not committed yet are sources too, files ignored by .gitignore are not
+    QProcess process;
+    process.setWorkingDirectory(folderPath);
+    process.start("git", QStringList() << "ls-files" << "-z" << "--cached" << "--others" << "--exclude-standard");
+    if (!process.waitForFinished(gitTimeoutMs) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        // Not a git work tree (or no git at all), the ignore list decides
+        process.kill();
+        process.waitForFinished();
+        return false;
+    }
+
+    // Paths are relative to the folder, also when it is a subdirectory of the work tree
+    const QList<QByteArray> paths = process.readAllStandardOutput().split('\0');
+    for (auto iter = paths.constBegin(); iter != paths.constEnd(); ++iter) {
+        if (iter->isEmpty()) {
+            continue;
+        }
+
+        QString path = QString::fromUtf8(*iter);
+        walk.gitFiles.insert(path);
+        for (int slash = path.lastIndexOf('/'); slash > 0; slash = path.lastIndexOf('/', slash - 1)) {
+            walk.gitDirectories.insert(path.left(slash));
+        }
+    }
+
+    return true;
+}
+
+bool SourceFingerprint::isIgnored(const QString &name, const QVector<QRegularExpression> &ignored) {
+    foreach (const QRegularExpression &pattern, ignored) {
+        if (pattern.match(name).hasMatch()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+QString SourceFingerprint::getCacheFile(const QString &serviceName) {
+    QDir appData(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    appData.mkpath("fingerprints");
+
+    // Service names may contain any character (':' for services of several roots), their hash is a valid and unique file name
+    QString fileName = QCryptographicHash::hash(serviceName.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return appData.filePath("fingerprints/" + fileName + ".cache");
+}
+
+SourceFingerprint::Cache SourceFingerprint::loadCache(const QString &cacheFile) {
+    Cache cache;
+    QFile file(cacheFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return cache;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic;
+    quint16 version;
+    stream >> magic >> version;
+    if (magic != cacheMagic || version != cacheVersion) {
+        return cache;
+    }
+
+    quint32 count;
+    stream >> cache.writtenMs >> count;
+    cache.files.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        FileEntry entry;
+        stream >> path >> entry.size >> entry.modifiedMs >> entry.hash;
+        cache.files.insert(path, entry);
+    }
+
+    // A damaged cache only costs hashing every file once
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Ignoring damaged fingerprint cache" << cacheFile;
+        return Cache();
+    }
+
+    return cache;
+}
+
+void SourceFingerprint::saveCache(const QString &cacheFile, const Cache &cache) {
+    QSaveFile file(cacheFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write fingerprint cache" << cacheFile << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << cacheMagic << cacheVersion << cache.writtenMs << static_cast<quint32>(cache.files.size());
+    for (auto iter = cache.files.constBegin(); iter != cache.files.constEnd(); ++iter) {
+        stream << iter.key() << iter.value().size << iter.value().modifiedMs << iter.value().hash;
+    }
+
+    file.commit();
+}
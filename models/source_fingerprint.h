@@ -0,0 +1,57 @@
+#ifndef SOURCE_FINGERPRINT_H
+#define SOURCE_FINGERPRINT_H
+
+#include <QByteArray>
+#include <QDir>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Merkle hash of the source tree of a service: files are hashed by content, directories by the
+// sorted names and hashes of their entries. In a git work tree only the files git knows about
+// (tracked, or new and not ignored by .gitignore) are part of it, elsewhere every file that does
+// not match the ignore list. The size and modification time of every file are cached per service
+// (fingerprints/<hash of the name>.cache in the app data directory), so only files that changed
+// since the last computation are read again.
+class SourceFingerprint {
+public:
+    static QByteArray compute(const QString &serviceName, const QString &folderPath, const QStringList &ignored);
+
+    // Names that are not sources: VCS data, dependencies, build output, editor files, logs and pid files
+    static const QStringList defaultIgnored;
+
+private:
+    struct FileEntry {
+        qint64 size = 0;
+        qint64 modifiedMs = 0;
+        QByteArray hash;
+    };
+
+    struct Cache {
+        qint64 writtenMs = 0;
+        QHash<QString, FileEntry> files;
+    };
+
+    struct Walk {
+        QVector<QRegularExpression> ignored;
+        bool gitWorkTree = false;
+        QSet<QString> gitFiles;
+        QSet<QString> gitDirectories;
+        Cache previous;
+        Cache current;
+        int hashedFiles = 0;
+    };
+
+    static QByteArray hashDirectory(const QDir &dir, const QString &relativePath, Walk &walk);
+    static QByteArray hashFile(const QString &filePath);
+    static bool listGitFiles(const QString &folderPath, Walk &walk);
+    static bool isIgnored(const QString &name, const QVector<QRegularExpression> &ignored);
+    static QString getCacheFile(const QString &serviceName);
+    static Cache loadCache(const QString &cacheFile);
+    static void saveCache(const QString &cacheFile, const Cache &cache);
+};
+
+#endif // SOURCE_FINGERPRINT_H
@@ -0,0 +1,601 @@
+#include "status_history.h"
+#include "utils/tracer.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTcpSocket>
+#include <QtEndian>
+
+#include <algorithm>
+
+namespace {
+const int recordSize = 16;
+const int indexEntrySize = 16;
+const int recordsPerIndexEntry = 256;
+const int flushIntervalMs = 5000;
+const int maxPendingRecords = 512;
+const int readinessIntervalMs = 500;
+const qint64 readinessTimeoutMs = 5 * 60 * 1000;
+const int maxReadySamples = 1000;
+const quint32 stateMagic = 0x4d4c5348; // "MLSH"
+const quint16 stateVersion = 1;
+
+// Records older than this are dropped once there are enough of them to be worth rewriting the log
+const qint64 retentionMs = 30LL * 24 * 60 * 60 * 1000;
+const qint64 minCompactedRecords = 64 * 1024;
+
+bool isRunningStatus(MicroserviceStatus status) {
+    return status != MicroserviceStatus::Inactive;
+}
+
+qint64 percentile(QVector<qint64> values, int percent) {
+    if (values.isEmpty()) {
+        return -1;
+    }
+
+    std::sort(values.begin(), values.end());
+    int rank = qMax(0, (percent * values.size() + 99) / 100 - 1);
+    return values.at(rank);
+}
+}
+
+StatusHistory::StatusHistory(QObject *parent)
+    : QObject(parent)
+    , recordCount(0)
+    , firstTimestampMs(0)
+    , lastTimestampMs(0)
+    , flushTimer(new QTimer(this))
+    , readinessTimer(new QTimer(this))
+{
+    QString appPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(appPath);
+
+    logFile.setFileName(appPath + "/history.log");
+    indexFile.setFileName(appPath + "/history.idx");
+    namesFile.setFileName(appPath + "/history.names");
+    stateFileName = appPath + "/history.state";
+
+    load();
+
+    if (!logFile.open(QIODevice::WriteOnly | QIODevice::Append)
+        || !indexFile.open(QIODevice::WriteOnly | QIODevice::Append)
+        || !namesFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to open status history in" << appPath;
+    }
+
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(flushIntervalMs);
+    connect(flushTimer, &QTimer::timeout, this, &StatusHistory::flush);
+
+    readinessTimer->setInterval(readinessIntervalMs);
+    connect(readinessTimer, &QTimer::timeout, this, &StatusHistory::probeReadiness);
+
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        flush();
+        saveState();
+    });
+}
+
+StatusHistory::~StatusHistory() {
+    flush();
+    saveState();
+}
+
+StatusHistory* StatusHistory::instance() {
+    // Owned by the application, so buffered records are written before Qt shuts down.
+    static StatusHistory *history = new StatusHistory(QCoreApplication::instance());
+    return history;
+}
+
+QByteArray StatusHistory::encode(const Record &record) {
+    QByteArray data(recordSize, '\0');
+    qToLittleEndian<qint64>(record.timestampMs, data.data());
+    qToLittleEndian<quint32>(record.serviceId, data.data() + 8);
+    data[12] = static_cast<char>(record.type);
+    data[13] = static_cast<char>(record.status);
+    return data;
+}
+
+StatusHistory::Record StatusHistory::decode(const char *data) {
+    Record record;
+    record.timestampMs = qFromLittleEndian<qint64>(data);
+    record.serviceId = qFromLittleEndian<quint32>(data + 8);
+    record.type = static_cast<quint8>(data[12]);
+    record.status = static_cast<quint8>(data[13]);
+    return record;
+}
+
+void StatusHistory::load() {
+    TraceSpan span("StatusHistory::load", "startup");
+
+    if (namesFile.open(QIODevice::ReadOnly)) {
+        serviceNames = QString::fromUtf8(namesFile.readAll()).split('\n', Qt::SkipEmptyParts);
+        namesFile.close();
+
+        for (int i = 0; i < serviceNames.size(); ++i) {
+            serviceIds.insert(serviceNames.at(i), static_cast<quint32>(i));
+        }
+    }
+
+    if (!logFile.open(QIODevice::ReadWrite)) {
+        return;
+    }
+
+    // A record cut off by a crash is dropped
+    qint64 completeSize = logFile.size() - logFile.size() % recordSize;
+    if (completeSize != logFile.size()) {
+        qWarning() << "Truncating incomplete record in" << logFile.fileName();
+        logFile.resize(completeSize);
+    }
+
+    // Only the records after the saved state are replayed; without a state that matches the log,
+    // the statistics and the index are rebuilt from the whole log
+    qint64 totalRecords = completeSize / recordSize;
+    if (!loadState(totalRecords) || !loadIndex(recordCount)) {
+        states.clear();
+        index.clear();
+        recordCount = 0;
+        firstTimestampMs = 0;
+        lastTimestampMs = 0;
+    }
+
+    qint64 replayedRecords = totalRecords - recordCount;
+    if (logFile.seek(recordCount * recordSize)) {
+        while (!logFile.atEnd()) {
+            QByteArray chunk = logFile.read(recordSize * 4096);
+            for (int offset = 0; offset + recordSize <= chunk.size(); offset += recordSize) {
+                Record record = decode(chunk.constData() + offset);
+
+                if (recordCount % recordsPerIndexEntry == 0) {
+                    index.append({record.timestampMs, recordCount});
+                }
+                if (recordCount == 0) {
+                    firstTimestampMs = record.timestampMs;
+                }
+
+                apply(record);
+                lastTimestampMs = record.timestampMs;
+                ++recordCount;
+            }
+        }
+    }
+
+    logFile.close();
+    qDebug() << "Status history:" << recordCount << "records," << replayedRecords << "replayed";
+
+    if (indexFile.size() != index.size() * indexEntrySize) {
+        writeIndex();
+    }
+
+    compact();
+}
+
+bool StatusHistory::loadState(qint64 totalRecords) {
+    QFile file(stateFileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic;
+    quint16 version;
+    stream >> magic >> version;
+    if (magic != stateMagic || version != stateVersion) {
+        return false;
+    }
+
+    qint32 count;
+    stream >> recordCount >> firstTimestampMs >> lastTimestampMs >> count;
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString serviceName;
+        ServiceState state;
+        quint8 status;
+        qint32 restarts;
+        stream >> serviceName >> state.known >> status >> state.statistics.upSinceMs >> state.statistics.lastDownMs
+               >> restarts >> state.lastStartMs >> state.readyDurations;
+        state.statistics.status = static_cast<MicroserviceStatus>(status);
+        state.statistics.restarts = restarts;
+        states.insert(serviceName, state);
+    }
+
+    // The state belongs to this log if the records it was saved after are still in their place
+    if (stream.status() != QDataStream::Ok || recordCount > totalRecords
+        || (recordCount > 0 && (readTimestamp(0) != firstTimestampMs || readTimestamp(recordCount - 1) != lastTimestampMs))) {
+        qWarning() << "Ignoring status history state that does not match the log";
+        return false;
+    }
+
+    return true;
+}
+
+bool StatusHistory::loadIndex(qint64 records) {
+    qint64 entries = (records + recordsPerIndexEntry - 1) / recordsPerIndexEntry;
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return entries == 0;
+    }
+
+    QByteArray data = indexFile.read(entries * indexEntrySize);
+    indexFile.close();
+    if (data.size() != entries * indexEntrySize) {
+        return false;
+    }
+
+    for (qint64 i = 0; i < entries; ++i) {
+        const char *entry = data.constData() + i * indexEntrySize;
+        IndexEntry indexEntry = {qFromLittleEndian<qint64>(entry), qFromLittleEndian<qint64>(entry + 8)};
+        if (indexEntry.recordNumber != i * recordsPerIndexEntry) {
+            index.clear();
+            return false;
+        }
+        index.append(indexEntry);
+    }
+
+    return true;
+}
+
+qint64 StatusHistory::readTimestamp(qint64 recordNumber) {
+    if (!logFile.seek(recordNumber * recordSize)) {
+        return -1;
+    }
+
+    QByteArray data = logFile.read(recordSize);
+    return data.size() == recordSize ? decode(data.constData()).timestampMs : -1;
+}
+
+void StatusHistory::saveState() {
+    // Records that are not written yet are not covered by the state
+    if (!pendingRecords.isEmpty()) {
+        return;
+    }
+
+    QSaveFile file(stateFileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write status history state" << stateFileName << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << stateMagic << stateVersion << recordCount << firstTimestampMs << lastTimestampMs << static_cast<qint32>(states.size());
+    for (auto iter = states.constBegin(); iter != states.constEnd(); ++iter) {
+        const ServiceState &state = iter.value();
+        stream << iter.key() << state.known << static_cast<quint8>(state.statistics.status) << state.statistics.upSinceMs
+               << state.statistics.lastDownMs << static_cast<qint32>(state.statistics.restarts) << state.lastStartMs << state.readyDurations;
+    }
+
+    file.commit();
+}
+
+void StatusHistory::writeIndex() {
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return;
+    }
+
+    for (auto iter = index.constBegin(); iter != index.constEnd(); ++iter) {
+        QByteArray entry(indexEntrySize, '\0');
+        qToLittleEndian<qint64>(iter->timestampMs, entry.data());
+        qToLittleEndian<qint64>(iter->recordNumber, entry.data() + 8);
+        indexFile.write(entry);
+    }
+
+    indexFile.close();
+}
+
+void StatusHistory::compact() {
+    // Whole index blocks are dropped, so the remaining entries only move by a multiple of the block size
+    qint64 cutoffMs = QDateTime::currentMSecsSinceEpoch() - retentionMs;
+    auto entry = std::upper_bound(index.constBegin(), index.constEnd(), cutoffMs, [](qint64 timestampMs, const IndexEntry &indexEntry) {
+        return timestampMs < indexEntry.timestampMs;
+    });
+    if (entry == index.constBegin()) {
+        return;
+    }
+
+    int droppedEntries = static_cast<int>(entry - index.constBegin()) - 1;
+    qint64 droppedRecords = static_cast<qint64>(droppedEntries) * recordsPerIndexEntry;
+    if (droppedRecords < minCompactedRecords) {
+        return;
+    }
+
+    TraceSpan span("StatusHistory::compact", "history");
+    QFile source(logFile.fileName());
+    QSaveFile target(logFile.fileName());
+    if (!source.open(QIODevice::ReadOnly) || !source.seek(droppedRecords * recordSize) || !target.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to compact status history:" << target.errorString();
+        return;
+    }
+
+    while (!source.atEnd()) {
+        target.write(source.read(recordSize * 4096));
+    }
+    source.close();
+
+    if (!target.commit()) {
+        qWarning() << "Failed to compact status history:" << target.errorString();
+        return;
+    }
+
+    // The statistics keep counting what the dropped records contributed
+    index.remove(0, droppedEntries);
+    for (auto iter = index.begin(); iter != index.end(); ++iter) {
+        iter->recordNumber -= droppedRecords;
+    }
+    recordCount -= droppedRecords;
+    firstTimestampMs = index.isEmpty() ? 0 : index.first().timestampMs;
+
+    qDebug() << "Dropped" << droppedRecords << "status history records older than" << retentionMs / (24 * 60 * 60 * 1000) << "days";
+    writeIndex();
+    saveState();
+}
+
+quint32 StatusHistory::getServiceId(const QString &serviceName) {
+    auto iter = serviceIds.constFind(serviceName);
+    if (iter != serviceIds.constEnd()) {
+        return iter.value();
+    }
+
+    quint32 id = static_cast<quint32>(serviceNames.size());
+    serviceNames.append(serviceName);
+    serviceIds.insert(serviceName, id);
+
+    // Names are written right away, so every flushed record refers to a known name
+    namesFile.write(serviceName.toUtf8() + '\n');
+    namesFile.flush();
+    return id;
+}
+
+void StatusHistory::append(const QString &serviceName, HistoryEventType type, MicroserviceStatus status) {
+    // Timestamps never go back, so the index stays sorted even if the clock is adjusted
+    lastTimestampMs = qMax(lastTimestampMs, QDateTime::currentMSecsSinceEpoch());
+
+    Record record;
+    record.timestampMs = lastTimestampMs;
+    record.serviceId = getServiceId(serviceName);
+    record.type = static_cast<quint8>(type);
+    record.status = static_cast<quint8>(status);
+
+    apply(record);
+    pendingRecords.append(record);
+
+    if (pendingRecords.size() >= maxPendingRecords) {
+        flush();
+    } else if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+}
+
+void StatusHistory::apply(const Record &record) {
+    if (record.serviceId >= static_cast<quint32>(serviceNames.size())) {
+        return;
+    }
+
+    ServiceState &state = states[serviceNames.at(record.serviceId)];
+    ServiceStatistics &statistics = state.statistics;
+
+    switch (static_cast<HistoryEventType>(record.type)) {
+    case HistoryEventType::StatusChanged: {
+        MicroserviceStatus status = static_cast<MicroserviceStatus>(record.status);
+        bool wasRunning = state.known && isRunningStatus(statistics.status);
+
+        if (isRunningStatus(status) && !wasRunning) {
+            statistics.upSinceMs = record.timestampMs;
+            if (statistics.lastDownMs > 0) {
+                statistics.restarts++;
+            }
+        } else if (!isRunningStatus(status) && wasRunning) {
+            statistics.upSinceMs = 0;
+            statistics.lastDownMs = record.timestampMs;
+        }
+
+        statistics.status = status;
+        state.known = true;
+        break;
+    }
+    case HistoryEventType::StartIssued:
+        state.lastStartMs = record.timestampMs;
+        break;
+    case HistoryEventType::StopIssued:
+        state.lastStartMs = 0;
+        break;
+    case HistoryEventType::Ready:
+        if (state.lastStartMs > 0) {
+            state.readyDurations.append(record.timestampMs - state.lastStartMs);
+            if (state.readyDurations.size() > maxReadySamples) {
+                state.readyDurations.removeFirst();
+            }
+            state.lastStartMs = 0;
+        }
+        break;
+    }
+}
+
+void StatusHistory::flush() {
+    if (pendingRecords.isEmpty() || !logFile.isOpen()) {
+        return;
+    }
+
+    TraceSpan span("StatusHistory::flush", "history");
+    flushTimer->stop();
+
+    QByteArray data;
+    QByteArray indexData;
+    data.reserve(pendingRecords.size() * recordSize);
+
+    qint64 firstRecord = recordCount;
+    if (recordCount == 0) {
+        firstTimestampMs = pendingRecords.first().timestampMs;
+    }
+
+    for (auto iter = pendingRecords.constBegin(); iter != pendingRecords.constEnd(); ++iter) {
+        if (recordCount % recordsPerIndexEntry == 0) {
+            IndexEntry entry = {iter->timestampMs, recordCount};
+            index.append(entry);
+
+            QByteArray encoded(indexEntrySize, '\0');
+            qToLittleEndian<qint64>(entry.timestampMs, encoded.data());
+            qToLittleEndian<qint64>(entry.recordNumber, encoded.data() + 8);
+            indexData += encoded;
+        }
+
+        data += encode(*iter);
+        ++recordCount;
+    }
+
+    if (logFile.write(data) != data.size()) {
+        qWarning() << "Failed to write status history:" << logFile.errorString();
+        recordCount = firstRecord;
+        while (!index.isEmpty() && index.last().recordNumber >= firstRecord) {
+            index.removeLast();
+        }
+        return;
+    }
+
+    logFile.flush();
+    if (!indexData.isEmpty()) {
+        indexFile.write(indexData);
+        indexFile.flush();
+    }
+
+    pendingRecords.clear();
+}
+
+void StatusHistory::recordStatus(const QString &serviceName, MicroserviceStatus status) {
+    const ServiceState state = states.value(serviceName);
+    if (state.known && state.statistics.status == status) {
+        return;
+    }
+
+    append(serviceName, HistoryEventType::StatusChanged, status);
+}
+
+void StatusHistory::recordStart(const QString &serviceName, const QVector<int> &ports) {
+    append(serviceName, HistoryEventType::StartIssued);
+
+    if (ports.isEmpty()) {
+        return;
+    }
+
+    PendingStart pending;
+    pending.issuedMs = QDateTime::currentMSecsSinceEpoch();
+    pending.ports = ports;
+    pendingStarts.insert(serviceName, pending);
+
+    if (!readinessTimer->isActive()) {
+        readinessTimer->start();
+    }
+}
+
+void StatusHistory::recordStop(const QString &serviceName) {
+    pendingStarts.remove(serviceName);
+    append(serviceName, HistoryEventType::StopIssued);
+}
+
+void StatusHistory::probeReadiness() {
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    for (auto iter = pendingStarts.begin(); iter != pendingStarts.end();) {
+        if (now - iter.value().issuedMs > readinessTimeoutMs) {
+            qDebug() << "Service" << iter.key() << "did not open its ports after the start command";
+            iter = pendingStarts.erase(iter);
+            continue;
+        }
+
+        // Connection attempts are asynchronous, so a filtered port does not block the interface
+        foreach (int port, iter.value().ports) {
+            QTcpSocket *socket = new QTcpSocket(this);
+            connect(socket, &QTcpSocket::connected, this, [this, socket, serviceName = iter.key()]() {
+                markReady(serviceName);
+                socket->deleteLater();
+            });
+            connect(socket, &QTcpSocket::errorOccurred, socket, &QObject::deleteLater);
+            QTimer::singleShot(readinessIntervalMs, socket, &QObject::deleteLater);
+            socket->connectToHost("127.0.0.1", port);
+        }
+
+        ++iter;
+    }
+
+    if (pendingStarts.isEmpty()) {
+        readinessTimer->stop();
+    }
+}
+
+void StatusHistory::markReady(const QString &serviceName) {
+    if (pendingStarts.remove(serviceName) == 0) {
+        return;
+    }
+
+    append(serviceName, HistoryEventType::Ready);
+}
+
+HistoryEvent StatusHistory::toEvent(const Record &record) const {
+    HistoryEvent event;
+    event.timestampMs = record.timestampMs;
+    event.serviceName = serviceNames.value(static_cast<int>(record.serviceId));
+    event.type = static_cast<HistoryEventType>(record.type);
+    event.status = static_cast<MicroserviceStatus>(record.status);
+    return event;
+}
+
+QVector<HistoryEvent> StatusHistory::getEvents(const QString &serviceName, qint64 fromMs, qint64 toMs) {
+    TraceSpan span("StatusHistory::getEvents", "history", serviceName);
+    QVector<HistoryEvent> events;
+
+    // An empty name selects the events of all services
+    qint64 serviceId = -1;
+    if (!serviceName.isEmpty()) {
+        if (!serviceIds.contains(serviceName)) {
+            return events;
+        }
+        serviceId = serviceIds.value(serviceName);
+    }
+
+    // The last index entry at or before the start of the range is where reading begins
+    auto entry = std::upper_bound(index.constBegin(), index.constEnd(), fromMs, [](qint64 timestampMs, const IndexEntry &indexEntry) {
+        return timestampMs < indexEntry.timestampMs;
+    });
+    qint64 firstRecord = entry == index.constBegin() ? 0 : (entry - 1)->recordNumber;
+
+    QFile file(logFile.fileName());
+    bool done = false;
+    if (file.open(QIODevice::ReadOnly) && file.seek(firstRecord * recordSize)) {
+        while (!done && !file.atEnd()) {
+            QByteArray chunk = file.read(recordSize * 1024);
+            for (int offset = 0; offset + recordSize <= chunk.size(); offset += recordSize) {
+                Record record = decode(chunk.constData() + offset);
+                if (record.timestampMs > toMs) {
+                    done = true;
+                    break;
+                }
+
+                if (record.timestampMs >= fromMs && (serviceId < 0 || record.serviceId == serviceId)) {
+                    events.append(toEvent(record));
+                }
+            }
+        }
+    }
+
+    for (auto iter = pendingRecords.constBegin(); !done && iter != pendingRecords.constEnd(); ++iter) {
+        if (iter->timestampMs > toMs) {
+            break;
+        }
+
+        if (iter->timestampMs >= fromMs && (serviceId < 0 || iter->serviceId == serviceId)) {
+            events.append(toEvent(*iter));
+        }
+    }
+
+    return events;
+}
+
+ServiceStatistics StatusHistory::getStatistics(const QString &serviceName) const {
+    ServiceState state = states.value(serviceName);
+    ServiceStatistics statistics = state.statistics;
+    statistics.readySamples = state.readyDurations.size();
+    statistics.readyP50Ms = percentile(state.readyDurations, 50);
+    statistics.readyP95Ms = percentile(state.readyDurations, 95);
+    return statistics;
+}
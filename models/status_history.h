@@ -0,0 +1,117 @@
+#ifndef STATUS_HISTORY_H
+#define STATUS_HISTORY_H
+
+#include "microservice_status.h"
+
+#include <QFile>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+enum class HistoryEventType : quint8 {
+    StatusChanged = 0,
+    StartIssued = 1,
+    StopIssued = 2,
+    Ready = 3
+};
+
+struct HistoryEvent {
+    qint64 timestampMs = 0;
+    QString serviceName;
+    HistoryEventType type = HistoryEventType::StatusChanged;
+    MicroserviceStatus status = MicroserviceStatus::Inactive;
+};
+
+struct ServiceStatistics {
+    MicroserviceStatus status = MicroserviceStatus::Inactive;
+    qint64 upSinceMs = 0;
+    qint64 lastDownMs = 0;
+    int restarts = 0;
+    int readySamples = 0;
+    qint64 readyP50Ms = -1;
+    qint64 readyP95Ms = -1;
+};
+
+// Append-only log of status transitions and start/stop commands of all services.
+// Records have a fixed size and are written in batches; a sparse index of record
+// timestamps allows range queries without reading the whole log. The statistics are
+// saved when the launcher exits, so a start only replays the records written after
+// that, and records older than the retention time are dropped from time to time.
+class StatusHistory : public QObject
+{
+    Q_OBJECT
+public:
+    static StatusHistory* instance();
+    ~StatusHistory();
+
+    void recordStatus(const QString &serviceName, MicroserviceStatus status);
+    void recordStart(const QString &serviceName, const QVector<int> &ports);
+    void recordStop(const QString &serviceName);
+    void flush();
+
+    QVector<HistoryEvent> getEvents(const QString &serviceName, qint64 fromMs, qint64 toMs);
+    ServiceStatistics getStatistics(const QString &serviceName) const;
+
+private:
+    // Stored as 16 little-endian bytes: timestamp (8), service id (4), type (1), status (1), reserved (2)
+    struct Record {
+        qint64 timestampMs = 0;
+        quint32 serviceId = 0;
+        quint8 type = 0;
+        quint8 status = 0;
+    };
+
+    struct IndexEntry {
+        qint64 timestampMs;
+        qint64 recordNumber;
+    };
+
+    struct PendingStart {
+        qint64 issuedMs = 0;
+        QVector<int> ports;
+    };
+
+    struct ServiceState {
+        ServiceStatistics statistics;
+        bool known = false;
+        qint64 lastStartMs = 0;
+        QVector<qint64> readyDurations;
+    };
+
+    explicit StatusHistory(QObject *parent = nullptr);
+    void load();
+    bool loadState(qint64 totalRecords);
+    bool loadIndex(qint64 records);
+    void saveState();
+    void writeIndex();
+    void compact();
+    qint64 readTimestamp(qint64 recordNumber);
+    quint32 getServiceId(const QString &serviceName);
+    void append(const QString &serviceName, HistoryEventType type, MicroserviceStatus status = MicroserviceStatus::Inactive);
+    void apply(const Record &record);
+    void probeReadiness();
+    void markReady(const QString &serviceName);
+    HistoryEvent toEvent(const Record &record) const;
+    static QByteArray encode(const Record &record);
+    static Record decode(const char *data);
+
+    QFile logFile;
+    QFile indexFile;
+    QFile namesFile;
+    QString stateFileName;
+    QStringList serviceNames;
+    QHash<QString, quint32> serviceIds;
+    QVector<IndexEntry> index;
+    QVector<Record> pendingRecords;
+    qint64 recordCount;
+    qint64 firstTimestampMs;
+    qint64 lastTimestampMs;
+    QHash<QString, ServiceState> states;
+    QHash<QString, PendingStart> pendingStarts;
+    QTimer *flushTimer;
+    QTimer *readinessTimer;
+};
+
+#endif // STATUS_HISTORY_H
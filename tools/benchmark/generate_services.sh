@@ -0,0 +1,83 @@
+#!/usr/bin/env bash
+# Generates a synthetic launcher environment with N service folders.
+#
+# Usage: generate_services.sh <root> <count> [legacy|info|all]
+#
+# With "info" a single service_info.sh describes each folder instead of short_name.sh and ports.sh,
+# with "all" one discover_all.sh call describes the whole directory.
+#
+# Layout:
+#   <root>/services/service-0001 ... service-N    Directory with service folders
+#   <root>/data/microservice-launcher/            Application data (config.ini, save.ini, scripts)
+#   <root>/data/microservice-launcher/benchmark   Marker that allows --benchmark to run with this data
+#
+# Run the launcher with XDG_DATA_HOME=<root>/data to make it use the generated data.
+
+set -euo pipefail
+
+if [ "$#" -lt 2 ] || [ "$#" -gt 3 ]; then
+    echo "Usage: $0 <root> <count> [legacy|info|all]" >&2
+    exit 1
+fi
+
+root="$1"
+count="$2"
+mode="${3:-legacy}"
+services_dir="$root/services"
+data_dir="$root/data/microservice-launcher"
+
+rm -rf "$root"
+mkdir -p "$services_dir" "$data_dir"
+
+for i in $(seq -f "%04g" 1 "$count"); do
+    mkdir "$services_dir/service-$i"
+done
+
+cat > "$data_dir/config.ini" <<INI
+[Main]
+Directory=$services_dir
+INI
+
+: > "$data_dir/save.ini"
+: > "$data_dir/benchmark"
+
+if [ "$mode" = "info" ]; then
+cat > "$data_dir/service_info.sh" <<'SCRIPT'
+#!/usr/bin/env bash
+name=$(basename "$1")
+index=$((10#${name##*-}))
+echo "short_name=s${name##*-}"
+echo "ports=$((20000 + index)) $((30000 + index))"
+echo "tags=benchmark"
+SCRIPT
+chmod +x "$data_dir/service_info.sh"
+fi
+
+if [ "$mode" = "all" ]; then
+cat > "$data_dir/discover_all.sh" <<'SCRIPT'
+#!/usr/bin/env bash
+while read -r name; do
+    index=$((10#${name##*-}))
+    printf '{"folder": "%s", "shortName": "s%s", "ports": [%d, %d], "tags": ["benchmark"]}\n' \
+        "$name" "${name##*-}" $((20000 + index)) $((30000 + index))
+done
+SCRIPT
+chmod +x "$data_dir/discover_all.sh"
+fi
+
+cat > "$data_dir/short_name.sh" <<'SCRIPT'
+#!/usr/bin/env bash
+name=$(basename "$1")
+echo "s${name##*-}"
+SCRIPT
+
+cat > "$data_dir/ports.sh" <<'SCRIPT'
+#!/usr/bin/env bash
+name=$(basename "$1")
+index=$((10#${name##*-}))
+echo "$((20000 + index)) $((30000 + index))"
+SCRIPT
+
+chmod +x "$data_dir/short_name.sh" "$data_dir/ports.sh"
+
+echo "Generated $count services in $services_dir"
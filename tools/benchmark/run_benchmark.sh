@@ -0,0 +1,40 @@
+#!/usr/bin/env bash
+# Runs the launcher benchmark scenario against synthetic service directories.
+#
+# Usage: run_benchmark.sh <launcher-binary> [output-dir] [counts...]
+#
+# For every count a fresh environment is generated, the launcher is started with
+# --benchmark and the aggregated span timings are written to
+# <output-dir>/results-<count>.json (plus a full Chrome trace in trace-<count>.json).
+
+set -euo pipefail
+
+if [ "$#" -lt 1 ]; then
+    echo "Usage: $0 <launcher-binary> [output-dir] [counts...]" >&2
+    exit 1
+fi
+
+binary="$(realpath "$1")"
+output_dir="${2:-benchmark-results}"
+shift $(( $# >= 2 ? 2 : 1 ))
+counts=("$@")
+if [ "${#counts[@]}" -eq 0 ]; then
+    counts=(100 1000 5000)
+fi
+
+script_dir="$(cd "$(dirname "$0")" && pwd)"
+work_dir="$(mktemp -d)"
+trap 'rm -rf "$work_dir"' EXIT
+
+mkdir -p "$output_dir"
+
+for count in "${counts[@]}"; do
+    "$script_dir/generate_services.sh" "$work_dir/$count" "$count"
+
+    XDG_DATA_HOME="$work_dir/$count/data" QT_QPA_PLATFORM=offscreen \
+        "$binary" \
+        --benchmark "$output_dir/results-$count.json" \
+        --trace "$output_dir/trace-$count.json"
+
+    echo "Results for $count services: $output_dir/results-$count.json"
+done
@@ -0,0 +1,9 @@
+QT       = core network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = fake_service
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,118 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <cstdlib>
+
+#if defined(Q_OS_LINUX)
+#include <sys/prctl.h>
+#endif
+
+// Stand-in for a real microservice: takes a process name, listens on the given ports
+// and can misbehave in the ways that make status detection slow or ambiguous.
+
+static void setProcessName(const QString &name) {
+#if defined(Q_OS_LINUX)
+    // ps -C matches the kernel comm name, which is limited to 15 characters.
+    prctl(PR_SET_NAME, name.left(15).toLocal8Bit().constData(), 0, 0, 0);
+#else
+    qWarning() << "Changing the process name is not supported on this platform, start the binary through a link named" << name;
+#endif
+}
+
+static QTcpServer* listenOnPort(int port, const QString &mode, QObject *parent) {
+    QTcpServer *server = new QTcpServer(parent);
+
+    if (mode == "blackhole") {
+        // The accept queue is filled by our own connections and never drained,
+        // so the kernel drops further SYNs and clients wait until they time out.
+        server->setListenBacklogSize(0);
+    }
+
+    if (!server->listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "Failed to listen on port" << port << server->errorString();
+        return server;
+    }
+
+    if (mode == "blackhole") {
+        server->pauseAccepting();
+        for (int i = 0; i < 2; ++i) {
+            QTcpSocket *socket = new QTcpSocket(server);
+            socket->connectToHost(QHostAddress::LocalHost, port);
+        }
+        return server;
+    }
+
+    QObject::connect(server, &QTcpServer::newConnection, server, [server, mode]() {
+        while (QTcpSocket *socket = server->nextPendingConnection()) {
+            if (mode == "reset") {
+                socket->abort();
+                socket->deleteLater();
+            } else {
+                QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            }
+        }
+    });
+
+    return server;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Fake microservice for reproducible status detection benchmarks.");
+    parser.addHelpOption();
+    QCommandLineOption nameOption("name", "Process name reported to ps.", "name");
+    QCommandLineOption portsOption("ports", "Comma separated list of ports to listen on.", "ports");
+    QCommandLineOption bindDelayOption("bind-delay", "Delay before the ports are bound, in milliseconds.", "ms", "0");
+    QCommandLineOption modeOption("mode", "Connection handling: accept, reset, refuse (ports are never bound) or blackhole.", "mode", "accept");
+    QCommandLineOption crashAfterOption("crash-after", "Abort the process after the given number of milliseconds.", "ms");
+    parser.addOption(nameOption);
+    parser.addOption(portsOption);
+    parser.addOption(bindDelayOption);
+    parser.addOption(modeOption);
+    parser.addOption(crashAfterOption);
+    parser.process(app);
+
+    const QString mode = parser.value(modeOption);
+    const QStringList modes = { "accept", "reset", "refuse", "blackhole" };
+    if (!modes.contains(mode)) {
+        qCritical() << "Unknown mode:" << mode;
+        return EXIT_FAILURE;
+    }
+
+    if (parser.isSet(nameOption)) {
+        setProcessName(parser.value(nameOption));
+    }
+
+    QList<int> ports;
+    foreach (const QString &portText, parser.value(portsOption).split(',', Qt::SkipEmptyParts)) {
+        bool ok;
+        int port = portText.trimmed().toInt(&ok);
+        if (!ok) {
+            qCritical() << "Invalid port:" << portText;
+            return EXIT_FAILURE;
+        }
+        ports.append(port);
+    }
+
+    if (mode != "refuse") {
+        QTimer::singleShot(parser.value(bindDelayOption).toInt(), &app, [&app, ports, mode]() {
+            for (int port : ports) {
+                listenOnPort(port, mode, &app);
+            }
+        });
+    }
+
+    if (parser.isSet(crashAfterOption)) {
+        QTimer::singleShot(parser.value(crashAfterOption).toInt(), &app, []() {
+            std::abort();
+        });
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,94 @@
+#!/usr/bin/env bash
+# Starts fake services for a synthetic environment and checks how the launcher classifies them.
+#
+# Usage: run_fake_services.sh <fake-service-binary> <launcher-binary> <count> [output-dir] [mode]
+#
+# Services are generated with tools/benchmark/generate_services.sh and split into thirds:
+#   service-N where N % 3 == 1   runs under its own name              -> expected Active
+#   service-N where N % 3 == 2   runs under another name on its ports -> expected Debug
+#   service-N where N % 3 == 0   is not started                       -> expected Inactive
+# The mode (accept, reset, refuse, blackhole) is passed to the Debug services. With
+# "refuse" and "blackhole" their ports never answer, so they are expected to be
+# Inactive; "blackhole" additionally reproduces the slow port probing case.
+
+set -euo pipefail
+
+if [ "$#" -lt 3 ]; then
+    echo "Usage: $0 <fake-service-binary> <launcher-binary> <count> [output-dir] [mode]" >&2
+    exit 1
+fi
+
+fake_service="$(realpath "$1")"
+launcher="$(realpath "$2")"
+count="$3"
+output_dir="${4:-fake-service-results}"
+mode="${5:-accept}"
+
+script_dir="$(cd "$(dirname "$0")" && pwd)"
+work_dir="$(mktemp -d)"
+pids=()
+
+cleanup() {
+    if [ "${#pids[@]}" -gt 0 ]; then
+        kill "${pids[@]}" 2>/dev/null || true
+    fi
+    rm -rf "$work_dir"
+}
+trap cleanup EXIT
+
+mkdir -p "$output_dir"
+"$script_dir/../benchmark/generate_services.sh" "$work_dir" "$count"
+
+expected_active=0
+expected_debug=0
+expected_inactive=0
+
+for i in $(seq 1 "$count"); do
+    name=$(printf "service-%04d" "$i")
+    ports="$((20000 + i)),$((30000 + i))"
+
+    case $((i % 3)) in
+        1)
+            "$fake_service" --name "$name" --ports "$ports" &
+            pids+=($!)
+            expected_active=$((expected_active + 1))
+            ;;
+        2)
+            "$fake_service" --name "fake-debug" --ports "$ports" --mode "$mode" &
+            pids+=($!)
+            if [ "$mode" = "refuse" ] || [ "$mode" = "blackhole" ]; then
+                expected_inactive=$((expected_inactive + 1))
+            else
+                expected_debug=$((expected_debug + 1))
+            fi
+            ;;
+        0)
+            expected_inactive=$((expected_inactive + 1))
+            ;;
+    esac
+done
+
+# Give the fake services time to bind their ports.
+sleep 2
+
+XDG_DATA_HOME="$work_dir/data" QT_QPA_PLATFORM=offscreen \
+    "$launcher" \
+    --benchmark "$output_dir/results-$count-$mode.json" \
+    --trace "$output_dir/trace-$count-$mode.json"
+
+results="$output_dir/results-$count-$mode.json"
+status=0
+for state in active debug inactive; do
+    expected_var="expected_$state"
+    expected="${!expected_var}"
+    actual=$(grep -o "\"$state\":[0-9]*" "$results" | cut -d: -f2)
+    if [ "$actual" != "$expected" ]; then
+        echo "Mismatch for $state services: expected $expected, got $actual" >&2
+        status=1
+    else
+        echo "$state services: $actual"
+    fi
+done
+
+echo "Refresh latency and other timings: $results"
+exit "$status"
@@ -0,0 +1,11 @@
+QT       = core testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_status_classification
+
+DEFINES += TOOLS_DIR=\\\"$$PWD/../..\\\"
+
+SOURCES += \
+    tst_status_classification.cpp
@@ -0,0 +1,134 @@
+#include <QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+
+// Starts fake services in the ways a real service can be found running, crashed or half started,
+// runs the launcher's benchmark scenario against them and checks the status of every service.
+
+namespace {
+    const int startupGraceMs = 2000;
+    const int launcherTimeoutMs = 120000;
+
+    struct FakeServiceCase {
+        QString name;
+        QStringList arguments;
+        QString expectedStatus;
+    };
+
+    QString serviceName(int index) {
+        return QString("service-%1").arg(index, 4, 10, QChar('0'));
+    }
+
+    QString servicePorts(int index) {
+        // Ports assigned by tools/benchmark/generate_services.sh
+        return QString("%1,%2").arg(20000 + index).arg(30000 + index);
+    }
+
+    QVector<FakeServiceCase> fakeServiceCases() {
+        // An empty argument list means the service is not started at all
+        return {
+            { "own name", { "--name", serviceName(1) }, "Active" },
+            { "other name", { "--name", "fake-debug" }, "Debug" },
+            { "not started", {}, "Inactive" },
+            { "other name, reset", { "--name", "fake-debug", "--mode", "reset" }, "Debug" },
+            { "other name, refuse", { "--name", "fake-debug", "--mode", "refuse" }, "Inactive" },
+            { "own name, crashed", { "--name", serviceName(6), "--crash-after", "200" }, "Inactive" },
+            { "other name, crashed", { "--name", "fake-debug", "--crash-after", "200" }, "Inactive" },
+            { "other name, bound late", { "--name", "fake-debug", "--bind-delay", "300" }, "Debug" },
+            { "other name, not bound yet", { "--name", "fake-debug", "--bind-delay", "600000" }, "Inactive" },
+            { "own name, not bound yet", { "--name", serviceName(10), "--bind-delay", "600000" }, "Active" },
+        };
+    }
+}
+
+class StatusClassificationTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void classification_data();
+    void classification();
+
+private:
+    QTemporaryDir workDir;
+    QList<QProcess*> fakeServices;
+    QJsonObject statuses;
+};
+
+void StatusClassificationTest::initTestCase() {
+    const QString fakeService = qEnvironmentVariable("FAKE_SERVICE_BINARY");
+    const QString launcher = qEnvironmentVariable("LAUNCHER_BINARY");
+    QVERIFY2(QFileInfo(fakeService).isExecutable(), "FAKE_SERVICE_BINARY must point to the fake_service binary");
+    QVERIFY2(QFileInfo(launcher).isExecutable(), "LAUNCHER_BINARY must point to the microservice-launcher binary");
+    QVERIFY(workDir.isValid());
+
+    const QVector<FakeServiceCase> cases = fakeServiceCases();
+
+    QProcess generator;
+    generator.start("bash", QStringList() << QString(TOOLS_DIR) + "/benchmark/generate_services.sh"
+                                          << workDir.path() << QString::number(cases.size()));
+    QVERIFY(generator.waitForFinished());
+    QCOMPARE(generator.exitCode(), 0);
+
+    for (int i = 0; i < cases.size(); ++i) {
+        if (cases[i].arguments.isEmpty()) {
+            continue;
+        }
+
+        QProcess *process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process->start(fakeService, cases[i].arguments + QStringList({ "--ports", servicePorts(i + 1) }));
+        QVERIFY2(process->waitForStarted(), qPrintable(process->errorString()));
+        fakeServices.append(process);
+    }
+
+    // Crashing services are gone and delayed ones have bound their ports by the time the launcher looks
+    QTest::qWait(startupGraceMs);
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("XDG_DATA_HOME", workDir.filePath("data"));
+    environment.insert("QT_QPA_PLATFORM", "offscreen");
+
+    const QString resultsFile = workDir.filePath("results.json");
+    QProcess launcherProcess;
+    launcherProcess.setProcessEnvironment(environment);
+    launcherProcess.setProcessChannelMode(QProcess::ForwardedChannels);
+    launcherProcess.start(launcher, QStringList() << "--benchmark" << resultsFile);
+    QVERIFY(launcherProcess.waitForFinished(launcherTimeoutMs));
+    QCOMPARE(launcherProcess.exitCode(), 0);
+
+    QFile file(resultsFile);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    statuses = QJsonDocument::fromJson(file.readAll()).object().value("statuses").toObject();
+    QCOMPARE(statuses.size(), cases.size());
+}
+
+void StatusClassificationTest::cleanupTestCase() {
+    foreach (QProcess *process, fakeServices) {
+        process->kill();
+        process->waitForFinished();
+    }
+}
+
+void StatusClassificationTest::classification_data() {
+    QTest::addColumn<QString>("service");
+    QTest::addColumn<QString>("expectedStatus");
+
+    const QVector<FakeServiceCase> cases = fakeServiceCases();
+    for (int i = 0; i < cases.size(); ++i) {
+        QTest::newRow(qPrintable(cases[i].name)) << serviceName(i + 1) << cases[i].expectedStatus;
+    }
+}
+
+void StatusClassificationTest::classification() {
+    QFETCH(QString, service);
+    QFETCH(QString, expectedStatus);
+
+    QCOMPARE(statuses.value(service).toString(), expectedStatus);
+}
+
+QTEST_GUILESS_MAIN(StatusClassificationTest)
+#include "tst_status_classification.moc"
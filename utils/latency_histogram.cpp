@@ -0,0 +1,69 @@
+#include "latency_histogram.h"
+
+#include <QtAlgorithms>
+
+namespace {
+const int subBucketBits = 6;
+const int subBucketCount = 1 << subBucketBits;     // 64 exact values
+const int subBucketHalf = subBucketCount / 2;      // 32 buckets per power of two above them
+const int maxShift = 40;                           // values up to 2^46 (about 2 years in microseconds)
+}
+
+LatencyHistogram::LatencyHistogram()
+    : counts(subBucketCount + maxShift * subBucketHalf, 0)
+    , totalCount(0)
+    , maxValue(0)
+{}
+
+int LatencyHistogram::bucketIndex(qint64 value) {
+    if (value < subBucketCount) {
+        return static_cast<int>(qMax<qint64>(0, value));
+    }
+
+    // The highest subBucketBits bits of the value select the bucket
+    int highestBit = 63 - qCountLeadingZeroBits(static_cast<quint64>(value));
+    int shift = qMin(highestBit - (subBucketBits - 1), maxShift);
+    qint64 subBucket = qMin<qint64>(value >> shift, subBucketCount - 1);
+    return subBucketCount + (shift - 1) * subBucketHalf + static_cast<int>(subBucket - subBucketHalf);
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index) {
+    if (index < subBucketCount) {
+        return index;
+    }
+
+    int shift = (index - subBucketCount) / subBucketHalf + 1;
+    qint64 subBucket = (index - subBucketCount) % subBucketHalf + subBucketHalf;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 value) {
+    counts[bucketIndex(value)]++;
+    totalCount++;
+    maxValue = qMax(maxValue, value);
+}
+
+qint64 LatencyHistogram::valueAtPercentile(double percentile) const {
+    if (totalCount == 0) {
+        return -1;
+    }
+
+    quint64 target = qMax<quint64>(1, static_cast<quint64>(percentile / 100.0 * totalCount + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < counts.size(); ++i) {
+        seen += counts.at(i);
+        if (seen >= target) {
+            return qMin(bucketUpperBound(i), maxValue);
+        }
+    }
+
+    return maxValue;
+}
+
+quint64 LatencyHistogram::getCount() const {
+    return totalCount;
+}
+
+qint64 LatencyHistogram::getMax() const {
+    return maxValue;
+}
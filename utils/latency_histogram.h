@@ -0,0 +1,26 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <QVector>
+
+// Log-linear histogram in the style of HdrHistogram: values below 64 are counted
+// exactly, larger values in 32 buckets per power of two (about 3% precision),
+// so memory stays constant no matter how many values are recorded.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+    void record(qint64 value);
+    qint64 valueAtPercentile(double percentile) const;
+    quint64 getCount() const;
+    qint64 getMax() const;
+
+private:
+    static int bucketIndex(qint64 value);
+    static qint64 bucketUpperBound(int index);
+
+    QVector<quint32> counts;
+    quint64 totalCount;
+    qint64 maxValue;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,133 @@
+#include "metrics.h"
+
+#include <QHash>
+
+#include <cmath>
+
+namespace {
+const QHash<QString, QString>& helpTexts() {
+    static const QHash<QString, QString> texts = {
+        {"launcher_service_status", "Current status of the service (1 for the active status label)."},
+        {"launcher_service_pid", "PID of the service, 0 if it is not running."},
+        {"launcher_service_processes", "Number of processes found for the service."},
+        {"launcher_service_resident_memory_bytes", "Resident memory of the processes of the service."},
+        {"launcher_service_cpu_seconds", "CPU time used by the running processes of the service."},
+        {"launcher_probe_duration_seconds", "Duration of TCP connection probes to the ports of the service."},
+        {"launcher_service_health", "Result of the last HTTP health check of the service (1 for the current state)."},
+        {"launcher_health_check_duration_seconds", "Response time of HTTP health checks of the service."},
+        {"launcher_command_duration_seconds", "Duration of executed command scripts."},
+        {"launcher_command_exit_code", "Exit code of the last execution of a command for a service."},
+        {"launcher_commands_total", "Number of executed command scripts by result."},
+        {"launcher_stop_duration_seconds", "Time services took to exit after Native Stop sent SIGTERM."},
+        {"launcher_forced_stops_total", "Number of services killed with SIGKILL after their grace period."},
+        {"launcher_crashes_total", "Number of times a service went down without a stop command."},
+        {"launcher_build_duration_seconds", "Duration of the build phase of a service."},
+        {"launcher_builds_total", "Number of builds by result."},
+        {"launcher_discovery_duration_seconds", "Duration of the last service discovery."},
+        {"launcher_discovery_directory_duration_seconds", "Duration of the last discovery of one directory."},
+        {"launcher_discovered_services", "Number of services found by the last discovery."},
+        {"launcher_refresh_duration_seconds", "Duration of status refreshes of all services."}
+    };
+    return texts;
+}
+}
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+QString Metrics::formatLabels(const MetricLabels &labels) {
+    QStringList parts;
+    for (auto iter = labels.constBegin(); iter != labels.constEnd(); ++iter) {
+        QString value = iter->second;
+        value.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+        parts << iter->first + "=\"" + value + "\"";
+    }
+
+    return parts.join(",");
+}
+
+QString Metrics::formatValue(double value) {
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+
+    return QString::number(value, 'g', 15);
+}
+
+Metrics::Series& Metrics::getSeries(const QString &name, Type type, const MetricLabels &labels) {
+    Family &family = families[name];
+    family.type = type;
+    return family.series[formatLabels(labels)];
+}
+
+void Metrics::setGauge(const QString &name, const MetricLabels &labels, double value) {
+    QMutexLocker locker(&mutex);
+    getSeries(name, Type::Gauge, labels).value = value;
+}
+
+void Metrics::increment(const QString &name, const MetricLabels &labels, double value) {
+    QMutexLocker locker(&mutex);
+    getSeries(name, Type::Counter, labels).value += value;
+}
+
+void Metrics::observe(const QString &name, const MetricLabels &labels, double value) {
+    QMutexLocker locker(&mutex);
+    Series &series = getSeries(name, Type::Summary, labels);
+    series.sum += value;
+    series.count++;
+}
+
+void Metrics::removeSeries(const QString &labelName, const QString &labelValue) {
+    QMutexLocker locker(&mutex);
+    QString label = formatLabels({{labelName, labelValue}});
+
+    for (auto family = families.begin(); family != families.end(); ++family) {
+        for (auto series = family->series.begin(); series != family->series.end();) {
+            // Labels are stored as formatted text, so the label is matched as a whole entry
+            const QString &key = series.key();
+            if (key == label || key.startsWith(label + ",") || key.contains("," + label + ",") || key.endsWith("," + label)) {
+                series = family->series.erase(series);
+            } else {
+                ++series;
+            }
+        }
+    }
+}
+
+QByteArray Metrics::render() const {
+    QMutexLocker locker(&mutex);
+    QByteArray output;
+
+    for (auto family = families.constBegin(); family != families.constEnd(); ++family) {
+        if (family->series.isEmpty()) {
+            continue;
+        }
+
+        const QString &name = family.key();
+        QString type = family->type == Type::Counter ? "counter" : family->type == Type::Summary ? "summary" : "gauge";
+        QString help = helpTexts().value(name);
+        if (!help.isEmpty()) {
+            output += "# HELP " + name.toUtf8() + " " + help.toUtf8() + "\n";
+        }
+        output += "# TYPE " + name.toUtf8() + " " + type.toUtf8() + "\n";
+
+        for (auto series = family->series.constBegin(); series != family->series.constEnd(); ++series) {
+            QString labels = series.key().isEmpty() ? QString() : "{" + series.key() + "}";
+
+            if (family->type == Type::Summary) {
+                output += (name + "_sum" + labels + " " + formatValue(series->sum) + "\n").toUtf8();
+                output += (name + "_count" + labels + " " + QString::number(series->count) + "\n").toUtf8();
+            } else {
+                output += (name + labels + " " + formatValue(series->value) + "\n").toUtf8();
+            }
+        }
+    }
+
+    return output;
+}
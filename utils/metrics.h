@@ -0,0 +1,51 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+
+typedef QList<QPair<QString, QString>> MetricLabels;
+
+// Metric values are updated by the code that changes them, so an export only formats
+// the current values (Prometheus text format) and never recomputes them.
+class Metrics {
+public:
+    static Metrics& instance();
+    void setGauge(const QString &name, const MetricLabels &labels, double value);
+    void increment(const QString &name, const MetricLabels &labels, double value = 1.0);
+    void observe(const QString &name, const MetricLabels &labels, double value);
+    void removeSeries(const QString &labelName, const QString &labelValue);
+    QByteArray render() const;
+
+private:
+    enum class Type {
+        Counter,
+        Gauge,
+        Summary
+    };
+
+    struct Series {
+        double value = 0;
+        double sum = 0;
+        quint64 count = 0;
+    };
+
+    struct Family {
+        Type type = Type::Gauge;
+        QMap<QString, Series> series;
+    };
+
+    Metrics() = default;
+    Series& getSeries(const QString &name, Type type, const MetricLabels &labels);
+    static QString formatLabels(const MetricLabels &labels);
+    static QString formatValue(double value);
+
+    mutable QMutex mutex;
+    QMap<QString, Family> families;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,65 @@
+#include "output_log.h"
+
+#include <QFile>
+#include <QMutexLocker>
+
+OutputLog& OutputLog::instance() {
+    static OutputLog outputLog;
+    return outputLog;
+}
+
+void OutputLog::append(const QString &serviceName, const QByteArray &output) {
+    if (output.isEmpty() || serviceName.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    Buffer &buffer = buffers[serviceName];
+
+    // Output arrives in arbitrary chunks, the unterminated tail waits for the rest of its line
+    QByteArray data = buffer.partialLine + output;
+    int start = 0;
+    int newline;
+    while ((newline = data.indexOf('\n', start)) != -1) {
+        buffer.lines.append(QString::fromUtf8(data.mid(start, newline - start)).trimmed());
+        start = newline + 1;
+    }
+    buffer.partialLine = data.mid(start);
+
+    while (buffer.lines.size() > maxLines) {
+        buffer.lines.removeFirst();
+    }
+}
+
+QStringList OutputLog::getLastLines(const QString &serviceName, int count) const {
+    QMutexLocker locker(&mutex);
+    const Buffer buffer = buffers.value(serviceName);
+
+    QStringList lines = buffer.lines;
+    if (!buffer.partialLine.isEmpty()) {
+        lines.append(QString::fromUtf8(buffer.partialLine).trimmed());
+    }
+
+    return lines.mid(qMax(0, lines.size() - count));
+}
+
+QStringList OutputLog::readLastLines(const QString &filePath, int count) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QStringList();
+    }
+
+    // Only the tail is read, service logs can be large
+    const qint64 tailSize = 64 * 1024;
+    if (file.size() > tailSize) {
+        file.seek(file.size() - tailSize);
+        file.readLine();
+    }
+
+    QStringList lines = QString::fromUtf8(file.readAll()).split('\n');
+    while (!lines.isEmpty() && lines.last().trimmed().isEmpty()) {
+        lines.removeLast();
+    }
+
+    return lines.mid(qMax(0, lines.size() - count));
+}
@@ -0,0 +1,34 @@
+#ifndef OUTPUT_LOG_H
+#define OUTPUT_LOG_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+// Keeps the last lines written by the scripts and supervised processes of each service,
+// so the output of a service that went down can still be shown afterwards.
+class OutputLog {
+public:
+    static OutputLog& instance();
+    void append(const QString &serviceName, const QByteArray &output);
+    QStringList getLastLines(const QString &serviceName, int count) const;
+
+    static QStringList readLastLines(const QString &filePath, int count);
+
+private:
+    struct Buffer {
+        QStringList lines;
+        QByteArray partialLine;
+    };
+
+    OutputLog() = default;
+
+    static const int maxLines = 200;
+
+    mutable QMutex mutex;
+    QHash<QString, Buffer> buffers;
+};
+
+#endif // OUTPUT_LOG_H
@@ -0,0 +1,143 @@
+#include "shell_worker.h"
+#include "tracer.h"
+
+#include <QCoreApplication>
+
+// Every request is one line: "<id>\t<command quoted as $'...'>". The command runs in a
+// forked subshell in the background, so several requests are executed in parallel.
+// Output lines are sent back as "<id>\tO\t<line>" and the exit code as "<id>\tX\t<code>".
+// The exit code follows the output as a line marked with \036, and the request is done once
+// it has been read: a process the command left in the background may keep the pipe open, so
+// its end is not waited for. Such a process gets SIGPIPE when it writes afterwards, as with
+// a script run by QProcess.
+static const char *driverScript =
+    "while IFS=$'\\t' read -r id quoted; do\n"
+    "  eval \"cmd=$quoted\"\n"
+    "  {\n"
+    "    { ( eval \"$cmd\" ) </dev/null; printf '\\036%s\\n' \"$?\"; } 2>&1 | {\n"
+    "      code=255\n"
+    "      while IFS= read -r line || [ -n \"$line\" ]; do\n"
+    "        case $line in\n"
+    "          *$'\\036'*)\n"
+    "            [ -n \"${line%$'\\036'*}\" ] && printf '%s\\tO\\t%s\\n' \"$id\" \"${line%$'\\036'*}\"\n"
+    "            code=${line##*$'\\036'}\n"
+    "            break\n"
+    "            ;;\n"
+    "        esac\n"
+    "        printf '%s\\tO\\t%s\\n' \"$id\" \"$line\"\n"
+    "      done\n"
+    "      printf '%s\\tX\\t%s\\n' \"$id\" \"$code\"\n"
+    "    }\n"
+    "  } &\n"
+    "done\n"
+    "wait\n";
+
+ShellWorker::ShellWorker(QObject *parent)
+    : QObject(parent)
+    , process(new QProcess(this))
+    , nextRequestId(1)
+{
+    connect(process, &QProcess::readyReadStandardOutput, this, &ShellWorker::readOutput);
+    connect(process, &QProcess::finished, this, [this](int exitCode) {
+        qWarning() << "Shell worker exited with code" << exitCode;
+    });
+}
+
+ShellWorker* ShellWorker::instance() {
+    // Owned by the application, so the shell is terminated before Qt shuts down.
+    static ShellWorker *worker = new ShellWorker(QCoreApplication::instance());
+    return worker;
+}
+
+bool ShellWorker::ensureStarted() {
+    if (process->state() == QProcess::Running) {
+        return true;
+    }
+
+    TraceSpan span("ShellWorker::start", "command");
+    buffer.clear();
+    process->setProgram("/usr/bin/env");
+    process->setArguments(QStringList() << "bash" << "-l" << "-c" << driverScript);
+    process->start();
+
+    if (!process->waitForStarted()) {
+        qWarning() << "Failed to start shell worker:" << process->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+QString ShellWorker::quote(const QString &argument) {
+    QString quoted = "$'";
+    for (const QChar &character : argument) {
+        switch (character.unicode()) {
+        case '\\':
+            quoted += "\\\\";
+            break;
+        case '\'':
+            quoted += "\\'";
+            break;
+        case '\n':
+            quoted += "\\n";
+            break;
+        case '\r':
+            quoted += "\\r";
+            break;
+        case '\t':
+            quoted += "\\t";
+            break;
+        default:
+            quoted += character;
+        }
+    }
+
+    return quoted + "'";
+}
+
+QString ShellWorker::commandLine(const QString &program, const QStringList &arguments) {
+    QStringList parts;
+    parts << quote(program);
+    for (auto iter = arguments.constBegin(); iter != arguments.constEnd(); ++iter) {
+        parts << quote(*iter);
+    }
+
+    return parts.join(' ');
+}
+
+int ShellWorker::submit(const QString &command) {
+    if (!ensureStarted()) {
+        return -1;
+    }
+
+    int requestId = nextRequestId++;
+    process->write(QByteArray::number(requestId) + '\t' + quote(command).toUtf8() + '\n');
+    return requestId;
+}
+
+void ShellWorker::readOutput() {
+    buffer += process->readAllStandardOutput();
+
+    int newline;
+    while ((newline = buffer.indexOf('\n')) != -1) {
+        QByteArray line = buffer.left(newline);
+        buffer.remove(0, newline + 1);
+
+        int firstTab = line.indexOf('\t');
+        int secondTab = line.indexOf('\t', firstTab + 1);
+        bool ok;
+        int requestId = line.left(firstTab).toInt(&ok);
+        if (firstTab == -1 || secondTab == -1 || !ok) {
+            continue; // Output of the login profile
+        }
+
+        QByteArray type = line.mid(firstTab + 1, secondTab - firstTab - 1);
+        QByteArray payload = line.mid(secondTab + 1);
+
+        if (type == "O") {
+            emit outputReceived(requestId, payload);
+        } else if (type == "X") {
+            emit finished(requestId, payload.toInt());
+        }
+    }
+}
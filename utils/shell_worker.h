@@ -0,0 +1,36 @@
+#ifndef SHELL_WORKER_H
+#define SHELL_WORKER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+
+// Long-lived login shell that executes commands sent over its stdin, so repeated
+// commands only pay for a fork instead of a new shell and profile startup. Requests
+// complete through signals only, the caller never waits for the shell.
+class ShellWorker : public QObject
+{
+    Q_OBJECT
+public:
+    static ShellWorker* instance();
+
+    int submit(const QString &command);
+
+    static QString quote(const QString &argument);
+    static QString commandLine(const QString &program, const QStringList &arguments);
+
+signals:
+    void outputReceived(int requestId, const QByteArray &line);
+    void finished(int requestId, int exitCode);
+
+private:
+    explicit ShellWorker(QObject *parent = nullptr);
+    bool ensureStarted();
+    void readOutput();
+
+    QProcess *process;
+    QByteArray buffer;
+    int nextRequestId;
+};
+
+#endif // SHELL_WORKER_H
@@ -0,0 +1,172 @@
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QThread>
+
+#include <limits>
+
+#if defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+Tracer::Tracer()
+    : enabled(false)
+{
+    clock.start();
+}
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::enable() {
+    enabled = true;
+}
+
+bool Tracer::isEnabled() const {
+    return enabled;
+}
+
+qint64 Tracer::nowNs() const {
+    return clock.nsecsElapsed();
+}
+
+quint64 Tracer::currentThreadId() const {
+#if defined(Q_OS_LINUX)
+    return static_cast<quint64>(syscall(SYS_gettid));
+#else
+    return reinterpret_cast<quint64>(QThread::currentThreadId());
+#endif
+}
+
+void Tracer::addEvent(const TraceEvent &event) {
+    QMutexLocker locker(&mutex);
+    events.append(event);
+}
+
+bool Tracer::writeTraceFile(const QString &fileName) const {
+    if (!enabled) {
+        return false;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+
+    QJsonObject processName;
+    processName.insert("name", "process_name");
+    processName.insert("ph", "M");
+    processName.insert("pid", pid);
+    processName.insert("args", QJsonObject{{"name", QCoreApplication::applicationName()}});
+    traceEvents.append(processName);
+
+    QMutexLocker locker(&mutex);
+    for (auto iter = events.constBegin(); iter != events.constEnd(); ++iter) {
+        QJsonObject event;
+        event.insert("name", iter->name);
+        event.insert("cat", iter->category);
+        event.insert("ph", "X");
+        // Chrome trace timestamps are microseconds; keep the nanosecond part as a fraction.
+        event.insert("ts", iter->startNs / 1000.0);
+        event.insert("dur", iter->durationNs / 1000.0);
+        event.insert("pid", pid);
+        event.insert("tid", static_cast<qint64>(iter->threadId));
+
+        if (!iter->detail.isEmpty()) {
+            event.insert("args", QJsonObject{{"detail", iter->detail}});
+        }
+
+        traceEvents.append(event);
+    }
+    locker.unlock();
+
+    QJsonObject root;
+    root.insert("traceEvents", traceEvents);
+    root.insert("displayTimeUnit", "ns");
+
+    return writeJsonFile(fileName, root);
+}
+
+bool Tracer::writeSummaryFile(const QString &fileName, const QJsonObject &metadata) const {
+    if (!enabled) {
+        return false;
+    }
+
+    struct Aggregate {
+        qint64 count = 0;
+        qint64 totalNs = 0;
+        qint64 minNs = std::numeric_limits<qint64>::max();
+        qint64 maxNs = 0;
+    };
+
+    QMap<QString, Aggregate> aggregates;
+
+    QMutexLocker locker(&mutex);
+    for (auto iter = events.constBegin(); iter != events.constEnd(); ++iter) {
+        Aggregate &aggregate = aggregates[iter->name];
+        aggregate.count++;
+        aggregate.totalNs += iter->durationNs;
+        aggregate.minNs = qMin(aggregate.minNs, iter->durationNs);
+        aggregate.maxNs = qMax(aggregate.maxNs, iter->durationNs);
+    }
+    locker.unlock();
+
+    QJsonObject spans;
+    for (auto iter = aggregates.constBegin(); iter != aggregates.constEnd(); ++iter) {
+        QJsonObject span;
+        span.insert("count", iter->count);
+        span.insert("totalNs", iter->totalNs);
+        span.insert("meanNs", iter->totalNs / iter->count);
+        span.insert("minNs", iter->minNs);
+        span.insert("maxNs", iter->maxNs);
+        spans.insert(iter.key(), span);
+    }
+
+    QJsonObject root = metadata;
+    root.insert("spans", spans);
+
+    return writeJsonFile(fileName, root);
+}
+
+bool Tracer::writeJsonFile(const QString &fileName, const QJsonObject &root) const {
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to write file:" << fileName << file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.close();
+
+    qDebug() << "Trace data written to:" << fileName;
+    return true;
+}
+
+TraceSpan::TraceSpan(const QString &name, const QString &category, const QString &detail)
+    : name(name)
+    , category(category)
+    , detail(detail)
+    , startNs(Tracer::instance().isEnabled() ? Tracer::instance().nowNs() : 0)
+{}
+
+TraceSpan::~TraceSpan() {
+    Tracer &tracer = Tracer::instance();
+    if (!tracer.isEnabled()) {
+        return;
+    }
+
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.detail = detail;
+    event.startNs = startNs;
+    event.durationNs = tracer.nowNs() - startNs;
+    event.threadId = tracer.currentThreadId();
+    tracer.addEvent(event);
+}
@@ -0,0 +1,54 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+struct TraceEvent {
+    QString name;
+    QString category;
+    QString detail;
+    qint64 startNs;
+    qint64 durationNs;
+    quint64 threadId;
+};
+
+class Tracer {
+public:
+    static Tracer& instance();
+    void enable();
+    bool isEnabled() const;
+    qint64 nowNs() const;
+    quint64 currentThreadId() const;
+    void addEvent(const TraceEvent &event);
+    bool writeTraceFile(const QString &fileName) const;
+    bool writeSummaryFile(const QString &fileName, const QJsonObject &metadata) const;
+
+private:
+    bool writeJsonFile(const QString &fileName, const QJsonObject &root) const;
+
+    Tracer();
+
+    bool enabled;
+    QElapsedTimer clock;
+    mutable QMutex mutex;
+    QVector<TraceEvent> events;
+};
+
+// Records the lifetime of the enclosing scope as one complete ("X") trace event.
+class TraceSpan {
+public:
+    explicit TraceSpan(const QString &name, const QString &category, const QString &detail = QString());
+    ~TraceSpan();
+
+private:
+    const QString name;
+    const QString category;
+    const QString detail;
+    qint64 startNs;
+};
+
+#endif // TRACER_H
@@ -1,27 +1,50 @@
 #include "mainwindow.h"
 #include "models/microservice_data.h"
 #include "ui_mainwindow.h"
+#include "utils/tracer.h"
+#include "models/port_registry.h"
+#include "models/service_discovery.h"
+#include "models/status_history.h"
+#include "controllers/rolling_restart.h"
+#include "controllers/build_pipeline.h"
 
 #include <QtWidgets/qpushbutton.h>
 #include <QSettings>
+#include <QSet>
 #include <QMessageBox>
 #include <QDoubleValidator>
 #include <QLabel>
 #include <QKeyEvent>
 #include <QSystemTrayIcon>
+#include <QJsonObject>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QDateTime>
+#include <QHeaderView>
+#include <QTableWidget>
+#include <QtConcurrent/QtConcurrent>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , servicesStatusLabel(new QLabel(this))
 {
+    TraceSpan constructorSpan("MainWindow::MainWindow", "startup");
     ui->setupUi(this);
 
     setWindowTitle(QStringLiteral("Microservice Launcher ") + QString(APP_VERSION));
     statusBar()->addPermanentWidget(servicesStatusLabel);
 
-    model = new Model();
-    controller = new Controller(model);
+    {
+        TraceSpan span("Model construction", "startup");
+        model = new Model();
+    }
+
+    {
+        TraceSpan span("Controller construction", "startup");
+        controller = new Controller(model);
+    }
 
     searchLineEdit = new QLineEdit(this);
     searchLineEdit->setPlaceholderText("Enter text to search");
@@ -53,6 +76,32 @@ MainWindow::MainWindow(QWidget *parent)
     searchLineEdit->installEventFilter(this);
 
     connect(qApp, &QApplication::aboutToQuit, this, &MainWindow::saveCheckBoxStateToFile);
+    connect(controller, &Controller::microserviceStateChanged, this, [this](const QString &serviceName) {
+        if (model->getMicroservices().contains(serviceName)) {
+            model->getMicroservices().value(serviceName)->refreshCheckboxState();
+            updateServicesStatus();
+        }
+    });
+    connect(controller, &Controller::microserviceCrashed, this, [this, trayIcon](const QString &serviceName, const QString &message, bool circuitOpen) {
+        statusBar()->showMessage(serviceName + ": " + message, 20000);
+        trayIcon->showMessage("Service down", serviceName + ": " + message,
+            circuitOpen ? QSystemTrayIcon::Critical : QSystemTrayIcon::Warning);
+    });
+    connect(controller, &Controller::sourcesChanged, this, [this](const QString &serviceName, const QString &commandName, const QStringList &commandArgs) {
+        MicroserviceData *microservice = model->getMicroservices().value(serviceName);
+        if (!microservice) {
+            return;
+        }
+
+        statusBar()->showMessage(QString("Sources of %1 changed, running %2...").arg(serviceName, commandName));
+        controller->executeScriptAsync(commandName, getServiceArguments(microservice, commandArgs), microservice, [this, serviceName, commandName](int exitCode) {
+            if (model->getMicroservices().contains(serviceName)) {
+                model->getMicroservices().value(serviceName)->refreshCheckboxState();
+                updateServicesStatus();
+            }
+            statusBar()->showMessage(QString("%1 for %2 finished with exit code %3").arg(commandName, serviceName).arg(exitCode), 10000);
+        });
+    });
 
     mainLayout = new QVBoxLayout(ui->centralwidget);
     mainLayout->setSpacing(0);
@@ -76,52 +125,295 @@ MainWindow::MainWindow(QWidget *parent)
     mainLayout->addLayout(searchLayout);
     mainLayout->addWidget(scrollArea);
 
+    loadLaunchSessionsFromFile();
+
+    TraceSpan layoutSpan("Build service layout", "ui");
     QSettings settings(model->getSaveFile(), QSettings::IniFormat);
     QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
     QMap<QString, MicroserviceData*>::const_iterator iter;
     for (iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
-        const QString &folderName = iter.key();
+        addMicroserviceLayout(iter.value(), settings);
+    }
 
-        if (saveCheckBox->isChecked()) {
-            settings.beginGroup("CheckBoxState");
-            bool isChecked = settings.value(folderName, false).toBool();
-            iter.value()->setCheckBoxChecked(isChecked);
-            settings.endGroup();
+    // A stale list is painted with the statuses of the last run and refreshed once discovery has finished
+    if (model->isStale()) {
+        startBackgroundDiscovery();
+    } else {
+        ProcessTree processTree = ProcessTree::snapshot();
+        for (iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+            iter.value()->refreshCheckboxState(processTree);
         }
+    }
+
+    if (saveCheckBox->isChecked()) {
+        loadCheckBoxStateFromFile();
+    }
+
+    controller->watchSources();
+
+    readWindowSizeFromConfig();
+    resize(width, height);
+    updateServicesStatus();
+}
+
+void MainWindow::addMicroserviceLayout(MicroserviceData *microservice, QSettings &settings) {
+    settings.beginGroup("Flag_" + microservice->getName());
+    foreach (QString flag, model->getFlagNames()) {
+        bool isChecked = settings.value(flag, false).toBool();
+        microservice->addFlag(flag, saveCheckBox->isChecked() ? isChecked : false);
+    }
+
+    settings.endGroup();
+    microservice->setFlagsVisible(showFlagControlPanelCheckBox->isChecked());
+
+    QHBoxLayout *rowLayout = new QHBoxLayout;
+    rowLayout->setAlignment(Qt::AlignLeft);
+    rowLayout->setSpacing(10);
+    rowLayout->addWidget(microservice->getStatusCheckBox());
+    rowLayout->addWidget(microservice->getCheckBox());
+    rowLayout->addWidget(microservice->getEnabledFlagsLabel());
+    rowLayout->addWidget(microservice->getHealthLabel());
+    rowLayout->addWidget(microservice->getSupervisionLabel());
+    rowLayout->addWidget(microservice->getResourceLabel());
+
+    microservice->getCheckBox()->installEventFilter(this);
+
+    microservice->getMicroserviceLayout()->addLayout(rowLayout);
+    contentLayout->addLayout(microservice->getMicroserviceLayout());
+
+    QHBoxLayout *flagsLayoutWithIndent = new QHBoxLayout;
+    flagsLayoutWithIndent->addSpacing(35);
+    flagsLayoutWithIndent->addLayout(microservice->getFlagsLayout());
+
+    microservice->getMicroserviceLayout()->addLayout(flagsLayoutWithIndent);
+
+    microservice->updateEnabledFlagsLabel();
+}
 
-        settings.beginGroup("Flag_"+iter.key());
-        foreach (QString flag, model->getFlagNames()) {
-            bool isChecked = settings.value(flag, false).toBool();
-            iter.value()->addFlag(flag, showFlagControlPanelCheckBox->isChecked(), saveCheckBox->isChecked() ? isChecked : false);
+void MainWindow::startBackgroundDiscovery() {
+    QStringList directories = model->getDirectories();
+    QStringList excludedFolders = model->getExcludedFolders();
+
+    QFutureWatcher<DiscoveryResult> *watcher = new QFutureWatcher<DiscoveryResult>(this);
+    connect(watcher, &QFutureWatcher<DiscoveryResult>::finished, this, [this, watcher]() {
+        DiscoveryResult result = watcher->result();
+        applyDiscovery(result);
+        watcher->deleteLater();
+    });
+
+    // Services are shown as soon as they are described, the complete result then removes the ones that are gone
+    ServiceCallback onDiscovered = [this](const ServiceInfo &info) {
+        QMetaObject::invokeMethod(this, [this, info]() {
+            queueDiscoveredService(info);
+        }, Qt::QueuedConnection);
+    };
+
+    // Statuses are checked in the worker too, since probing the ports of a service can take a second
+    QHash<QString, ServiceInfo> listedServices;
+    QHash<QString, int> launchSessions = savedLaunchSessions;
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        listedServices.insert(iter.key(), iter.value()->getServiceInfo());
+        launchSessions.insert(iter.key(), iter.value()->getLaunchSessionId());
+    }
+
+    watcher->setFuture(QtConcurrent::run([directories, excludedFolders, onDiscovered, listedServices, launchSessions]() {
+        DiscoveryResult result;
+        result.services = ServiceDiscovery::discover(directories, excludedFolders, onDiscovered);
+        result.processTree = ProcessTree::snapshot();
+
+        // A discovered service is probed with its new ports
+        QHash<QString, ServiceInfo> probedServices = listedServices;
+        for (auto iter = result.services.constBegin(); iter != result.services.constEnd(); ++iter) {
+            probedServices.insert(iter->name, *iter);
+        }
+        for (auto iter = probedServices.constBegin(); iter != probedServices.constEnd(); ++iter) {
+            result.probes.insert(iter.key(), MicroserviceData::probe(iter.value(), launchSessions.value(iter.key()), result.processTree));
         }
+        return result;
+    }));
+}
 
-        settings.endGroup();
+void MainWindow::queueDiscoveredService(const ServiceInfo &info) {
+    // Services arriving together are added in one pass, so the list is not rebuilt for every line
+    if (discoveredServices.isEmpty()) {
+        QTimer::singleShot(100, this, &MainWindow::applyDiscoveredServices);
+    }
 
-        QHBoxLayout *rowLayout = new QHBoxLayout;
-        rowLayout->setAlignment(Qt::AlignLeft);
-        rowLayout->setSpacing(10);
-        rowLayout->addWidget(iter.value()->getStatusCheckBox());
-        rowLayout->addWidget(iter.value()->getCheckBox());
-        rowLayout->addWidget(iter.value()->getEnabledFlagsLabel());
+    discoveredServices.append(info);
+}
 
-        iter.value()->getCheckBox()->installEventFilter(this);
+void MainWindow::applyDiscoveredServices() {
+    if (discoveredServices.isEmpty()) {
+        return;
+    }
 
-        iter.value()->getMicroserviceLayout()->addLayout(rowLayout);
-        contentLayout->addLayout(iter.value()->getMicroserviceLayout());
+    ServiceChanges changes = model->merge(discoveredServices);
+    discoveredServices.clear();
 
-        QHBoxLayout *flagsLayoutWithIndent = new QHBoxLayout;
-        flagsLayoutWithIndent->addSpacing(35);
-        flagsLayoutWithIndent->addLayout(iter.value()->getFlagsLayout());
+    addServiceRows(changes.added);
+    if (!changes.added.isEmpty()) {
+        onSearchLineEditTextChanged();
+        updateServicesStatus();
+    }
+}
 
-        iter.value()->getMicroserviceLayout()->addLayout(flagsLayoutWithIndent);
+void MainWindow::addServiceRows(const QVector<MicroserviceData*> &microservices) {
+    QSettings settings(model->getSaveFile(), QSettings::IniFormat);
+    for (auto iter = microservices.constBegin(); iter != microservices.constEnd(); ++iter) {
+        addMicroserviceLayout(*iter, settings);
 
-        iter.value()->refreshCheckboxState();
-        iter.value()->updateEnabledFlagsLabel();
+        if (saveCheckBox->isChecked()) {
+            (*iter)->setCheckBoxChecked(settings.value("CheckBoxState/" + (*iter)->getName(), false).toBool());
+        }
+        (*iter)->setLaunchSessionId(savedLaunchSessions.value((*iter)->getName()));
+    }
+}
+
+void MainWindow::applyDiscovery(const DiscoveryResult &result) {
+    TraceSpan span("MainWindow::applyDiscovery", "discovery");
+
+    // The complete result supersedes partial results that have not been applied yet
+    discoveredServices.clear();
+
+    // Statuses are brought up to date first, since removal is decided by them
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        if (result.probes.contains(iter.key())) {
+            iter.value()->applyProbe(result.probes.value(iter.key()), result.processTree);
+        }
+    }
+
+    // Services that are running or supervised stay in the list even if their folder is gone
+    ServiceChanges changes = model->reconcile(result.services, [this](MicroserviceData *microservice) {
+        return microservice->getStatus() == MicroserviceStatus::Inactive && !controller->isSupervised(microservice->getName());
+    });
+
+    addServiceRows(changes.added);
+
+    for (auto iter = changes.removed.constBegin(); iter != changes.removed.constEnd(); ++iter) {
+        contentLayout->removeItem((*iter)->getMicroserviceLayout());
+        delete *iter;
+    }
+
+    if (!changes.added.isEmpty() || !changes.removed.isEmpty()) {
+        onSearchLineEditTextChanged();
+    }
+
+    // Services with new ports already got the status probed with them, added services get it now
+    for (auto iter = changes.added.constBegin(); iter != changes.added.constEnd(); ++iter) {
+        (*iter)->applyProbe(result.probes.value((*iter)->getName()), result.processTree);
     }
 
-    readWindowSizeFromConfig();
-    resize(width, height);
     updateServicesStatus();
+    controller->watchSources();
+
+    if (!changes.added.isEmpty() || !changes.updated.isEmpty() || !changes.removed.isEmpty()) {
+        statusBar()->showMessage(QString("Services updated: %1 added, %2 changed, %3 removed")
+            .arg(changes.added.size())
+            .arg(changes.updated.size())
+            .arg(changes.removed.size()), 10000);
+    }
+}
+
+void MainWindow::loadCheckBoxStateFromFile() {
+    TraceSpan span("MainWindow::loadCheckBoxStateFromFile", "config");
+    QSettings settings(model->getSaveFile(), QSettings::IniFormat);
+    settings.beginGroup("CheckBoxState");
+
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    QMap<QString, MicroserviceData*>::const_iterator iter;
+    for (iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        bool isChecked = settings.value(iter.key(), false).toBool();
+        iter.value()->setCheckBoxChecked(isChecked);
+    }
+
+    settings.endGroup();
+}
+
+void MainWindow::loadLaunchSessionsFromFile() {
+    QSettings settings(model->getSaveFile(), QSettings::IniFormat);
+    settings.beginGroup("LaunchSessions");
+
+    // Each entry is "session id, start time of its last process, boot id". A session id of an earlier
+    // boot, or one reused since, belongs to other processes and is dropped. Without a boot id or a
+    // start time a reused id cannot be told apart, so such sessions are not restored at all.
+    ProcessTree processTree = ProcessTree::snapshot();
+    QString bootId = ProcessTree::bootId();
+    QStringList serviceNames = settings.childKeys();
+    for (auto iter = serviceNames.constBegin(); iter != serviceNames.constEnd(); ++iter) {
+        QStringList session = settings.value(*iter).toStringList();
+        if (bootId.isEmpty() || session.size() != 3 || session.at(2) != bootId) {
+            continue;
+        }
+
+        int sessionId = session.at(0).toInt();
+        qint64 lastStart = session.at(1).toLongLong();
+        if (lastStart <= 0 || !processTree.hasStartedInSessionBy(sessionId, lastStart)) {
+            continue;
+        }
+
+        savedLaunchSessions.insert(*iter, sessionId);
+        if (model->getMicroservices().contains(*iter)) {
+            model->getMicroservices().value(*iter)->setLaunchSessionId(sessionId);
+        }
+    }
+
+    settings.endGroup();
+}
+
+void MainWindow::saveLaunchSessionsToFile() {
+    QSettings settings(model->getSaveFile(), QSettings::IniFormat);
+    settings.remove("LaunchSessions");
+    settings.beginGroup("LaunchSessions");
+
+    ProcessTree processTree = ProcessTree::snapshot();
+    QString bootId = ProcessTree::bootId();
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    QMap<QString, MicroserviceData*>::const_iterator iter;
+    for (iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        int sessionId = iter.value()->getLaunchSessionId();
+        if (sessionId > 0 && !processTree.getPidsInSession(sessionId).isEmpty()) {
+            settings.setValue(iter.key(), QStringList()
+                << QString::number(sessionId)
+                << QString::number(processTree.getLastStartInSession(sessionId))
+                << bootId);
+        }
+    }
+
+    settings.endGroup();
+}
+
+void MainWindow::runBenchmark(const QString &resultsFile) {
+    TraceSpan span("MainWindow::runBenchmark", "benchmark");
+
+    for (int i = 0; i < 3; ++i) {
+        onRefreshButtonClicked();
+    }
+
+    const QStringList searchQueries = { "s", "service", "1", "no-such-service", "" };
+    for (auto iter = searchQueries.constBegin(); iter != searchQueries.constEnd(); ++iter) {
+        searchLineEdit->setText(*iter);
+    }
+
+    controller->selectAll();
+    saveCheckBoxStateToFile();
+    loadCheckBoxStateFromFile();
+
+    QJsonObject metadata;
+    metadata.insert("version", QString(APP_VERSION));
+    metadata.insert("services", model->getMicroservices().getDataMap().size());
+    metadata.insert("active", model->getMicroservices().getServicesByStatus(MicroserviceStatus::Active).size());
+    metadata.insert("debug", model->getMicroservices().getServicesByStatus(MicroserviceStatus::Debug).size());
+    metadata.insert("inactive", model->getMicroservices().getServicesByStatus(MicroserviceStatus::Inactive).size());
+
+    QJsonObject statuses;
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        statuses.insert(iter.key(), microserviceStatusToString(iter.value()->getStatus()));
+    }
+    metadata.insert("statuses", statuses);
+    Tracer::instance().writeSummaryFile(resultsFile, metadata);
 }
 
 void MainWindow::updateServicesStatus()
@@ -132,7 +424,10 @@ void MainWindow::updateServicesStatus()
 
     int runningServices = activeServices + debugServices;
 
-    servicesStatusLabel->setText(QString("Running services: %1/%2").arg(runningServices).arg(totalServices));
+    servicesStatusLabel->setText(QString("Running services: %1/%2%3")
+        .arg(runningServices)
+        .arg(totalServices)
+        .arg(model->isStale() ? " (last known, refreshing...)" : ""));
 }
 
 void MainWindow::onAddCommandClicked() {
@@ -337,6 +632,30 @@ void MainWindow::onRefreshButtonClicked() {
     updateServicesStatus();
 }
 
+void MainWindow::onNativeStopButtonClicked() {
+    QVector<MicroserviceData*> checkedServices = model->getMicroservices().getCheckedServices();
+    if (checkedServices.isEmpty()) {
+        statusBar()->showMessage("No services selected", 5000);
+        return;
+    }
+
+    GracefulStop *gracefulStop = controller->stopServices(checkedServices);
+    statusBar()->showMessage(QString("Stopping %1 services...").arg(checkedServices.size()));
+
+    connect(gracefulStop, &GracefulStop::finished, this, [this, gracefulStop]() {
+        onRefreshButtonClicked();
+
+        QString message = QString("Stopped %1 services").arg(gracefulStop->getStopped().size() + gracefulStop->getForced().size());
+        if (!gracefulStop->getForced().isEmpty()) {
+            message += ", killed after the grace period: " + gracefulStop->getForced().join(", ");
+        }
+        if (!gracefulStop->getSurvivors().isEmpty()) {
+            message += ", still running: " + gracefulStop->getSurvivors().join(", ");
+        }
+        statusBar()->showMessage(message, 20000);
+    });
+}
+
 void MainWindow::loadSettings() {
     QSettings settings(model->getSaveFile(), QSettings::IniFormat);
 
@@ -401,6 +720,10 @@ void MainWindow::loadSettings() {
     connect(addSaveAction, &QAction::triggered, this, &MainWindow::onAddSaveClicked);
     settingsMenu->addAction(addSaveAction);
 
+    QAction *statusHistoryAction = new QAction("Status History", this);
+    connect(statusHistoryAction, &QAction::triggered, this, &MainWindow::showStatusHistoryDialog);
+    settingsMenu->addAction(statusHistoryAction);
+
     QAction *aboutAction = new QAction("About", this);
     connect(aboutAction, &QAction::triggered, this, &MainWindow::showAboutDialog);
     settingsMenu->addAction(aboutAction);
@@ -421,6 +744,17 @@ void MainWindow::loadSavesFromConfigFile() {
         saveMenu->addAction(save);
     }
 
+    if (!saveNames.isEmpty()) {
+        QMenu *convergeMenu = saveMenu->addMenu("Converge To");
+        for (auto iter = saveNames.constBegin(); iter != saveNames.constEnd(); ++iter) {
+            QAction *converge = new QAction(*iter, this);
+            connect(converge, &QAction::triggered, this, [this, saveName = *iter]() {
+                convergeToSave(saveName);
+            });
+            convergeMenu->addAction(converge);
+        }
+    }
+
     settings.endGroup();
 }
 
@@ -437,6 +771,8 @@ void MainWindow::loadCommandsFromConfigFile() {
             connect(action, &QAction::triggered, this, &MainWindow::onDeselectAllButtonClicked);
         } else if (commandName == "Refresh") {
             connect(action, &QAction::triggered, this, &MainWindow::onRefreshButtonClicked);
+        } else if (commandName == "Native Stop") {
+            connect(action, &QAction::triggered, this, &MainWindow::onNativeStopButtonClicked);
         } else {
             connect(action, &QAction::triggered, this, [this, commandName]() {
                 onCustomButtonClicked(commandName);
@@ -471,6 +807,8 @@ void MainWindow::loadMainWindowButtonsFromConfigFile() {
                 connect(pushButton, &QPushButton::clicked, this, &MainWindow::onDeselectAllButtonClicked);
             } else if (*commandIter == "Refresh") {
                 connect(pushButton, &QPushButton::clicked, this, &MainWindow::onRefreshButtonClicked);
+            } else if (*commandIter == "Native Stop") {
+                connect(pushButton, &QPushButton::clicked, this, &MainWindow::onNativeStopButtonClicked);
             } else {
                 connect(pushButton, &QPushButton::clicked, this, [this, commandName = *commandIter]() {
                     onCustomButtonClicked(commandName);
@@ -539,28 +877,299 @@ QStringList MainWindow::getCommandArguments(const QString &commandName) {
 }
 
 void MainWindow::executeForSelectedMicroservices(const QString &commandName, const QStringList &commandArgs) {
+    QStringList excludedServices = controller->getCommandExcludedServices(commandName);
+    QVector<MicroserviceStatus> requiredStatuses = controller->getCommandRequiredStatuses(commandName);
+
+    // One status snapshot for the whole batch, taken before any script runs
+    ProcessTree processTree = ProcessTree::snapshot();
+    QVector<MicroserviceData*> targetServices;
+    QStringList skippedServices;
+
     QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
     for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
         if (!iter.value()->getCheckBox()->isChecked()) {
             continue; // Skip if checkbox is not checked
         }
 
-        QString processName = iter.key();
-        if (controller->getCommandExcludedServices(commandName).contains(processName)) {
+        if (excludedServices.contains(iter.key())) {
             continue; // Skip excluded services
         }
 
-        iter.value()->refreshCheckboxState();
-        QString pid = iter.value()->getPIDByPorts();
+        iter.value()->refreshCheckboxState(processTree);
+
+        if (!requiredStatuses.isEmpty() && !requiredStatuses.contains(iter.value()->getStatus())) {
+            skippedServices << iter.key() + " (" + microserviceStatusToString(iter.value()->getStatus()) + ")";
+            continue; // Skip services that are already in the target state
+        }
+
+        targetServices.append(iter.value());
+    }
+
+    updateServicesStatus();
+
+    PortCheck portCheck = controller->getCommandPortCheck(commandName);
+    if (portCheck != PortCheck::None && !targetServices.isEmpty()) {
+        PortRegistry portRegistry(model->getMicroservices(), processTree);
+        QVector<PortConflict> conflicts = portRegistry.findConflicts(targetServices);
+
+        if (!conflicts.isEmpty()) {
+            QStringList descriptions;
+            QSet<QString> conflictingServices;
+            for (auto iter = conflicts.constBegin(); iter != conflicts.constEnd(); ++iter) {
+                descriptions << iter->describe();
+                conflictingServices.insert(iter->serviceName);
+            }
+
+            qWarning() << "Port conflicts:" << descriptions;
+
+            bool skipConflicting = true;
+            if (portCheck == PortCheck::Warn) {
+                QMessageBox::StandardButton answer = QMessageBox::warning(
+                    this,
+                    "Port Conflicts",
+                    "The following ports are already in use:\n\n" + descriptions.join("\n") + "\n\nExecute the command for these services anyway?",
+                    QMessageBox::Yes | QMessageBox::No,
+                    QMessageBox::No);
+                skipConflicting = answer != QMessageBox::Yes;
+            } else {
+                QMessageBox::warning(this, "Port Conflicts", "The command is not executed for services with port conflicts:\n\n" + descriptions.join("\n"));
+            }
+
+            if (skipConflicting) {
+                for (int i = targetServices.size() - 1; i >= 0; --i) {
+                    if (conflictingServices.contains(targetServices.at(i)->getName())) {
+                        skippedServices << targetServices.at(i)->getName() + " (port conflict)";
+                        targetServices.remove(i);
+                    }
+                }
+            }
+        }
+    }
+
+    if (!skippedServices.isEmpty()) {
+        qDebug() << "Command" << commandName << "skipped services:" << skippedServices;
+        statusBar()->showMessage(QString("%1: skipped %2 of %3 services: %4")
+            .arg(commandName)
+            .arg(skippedServices.size())
+            .arg(skippedServices.size() + targetServices.size())
+            .arg(skippedServices.join(", ")), 10000);
+    }
+
+    if (controller->getCommandBatch(commandName)) {
+        if (targetServices.isEmpty()) {
+            return;
+        }
+
+        statusBar()->showMessage(QString("%1: running batch script for %2 services...").arg(commandName).arg(targetServices.size()));
+        controller->executeBatchScript(commandName, targetServices, commandArgs, [this, commandName](const QMap<QString, int> &results) {
+            QStringList failedServices;
+            for (auto iter = results.constBegin(); iter != results.constEnd(); ++iter) {
+                if (iter.value() != 0) {
+                    failedServices << iter.key();
+                }
+            }
+
+            onRefreshButtonClicked();
+            statusBar()->showMessage(QString("%1: %2 of %3 services succeeded%4")
+                .arg(commandName)
+                .arg(results.size() - failedServices.size())
+                .arg(results.size())
+                .arg(failedServices.isEmpty() ? QString() : ", failed: " + failedServices.join(", ")), 10000);
+        });
+        return;
+    }
+
+    if (controller->getCommandOptions(commandName).rollingBatchSize > 0) {
+        if (targetServices.isEmpty()) {
+            return;
+        }
+
+        QStringList serviceNames;
+        for (auto iter = targetServices.constBegin(); iter != targetServices.constEnd(); ++iter) {
+            serviceNames << (*iter)->getName();
+        }
+
+        // Arguments are collected when a batch starts, so PIDs are those of the running instance
+        RollingRestart *rollingRestart = new RollingRestart(model, controller, commandName, serviceNames,
+            [this, commandArgs](MicroserviceData *microservice) {
+                return getServiceArguments(microservice, commandArgs);
+            }, this);
+        connect(rollingRestart, &RollingRestart::progress, this, [this](const QString &message) {
+            statusBar()->showMessage(message);
+        });
+        connect(rollingRestart, &RollingRestart::finished, this, [this](const QString &summary) {
+            onRefreshButtonClicked();
+            statusBar()->showMessage(summary, 20000);
+        });
+        rollingRestart->start();
+        return;
+    }
+
+    if (!controller->getCommandOptions(commandName).buildCommand.isEmpty()) {
+        if (targetServices.isEmpty()) {
+            return;
+        }
+
+        QStringList serviceNames;
+        for (auto iter = targetServices.constBegin(); iter != targetServices.constEnd(); ++iter) {
+            serviceNames << (*iter)->getName();
+        }
+
+        BuildPipeline *buildPipeline = new BuildPipeline(model, controller, commandName, serviceNames,
+            [this, commandArgs](MicroserviceData *microservice) {
+                return getServiceArguments(microservice, commandArgs);
+            }, this);
+        connect(buildPipeline, &BuildPipeline::progress, this, [this](const QString &message) {
+            statusBar()->showMessage(message);
+        });
+        connect(buildPipeline, &BuildPipeline::finished, this, [this](const QString &summary) {
+            onRefreshButtonClicked();
+            statusBar()->showMessage(summary, 20000);
+        });
+        buildPipeline->start();
+        return;
+    }
+
+    for (auto iter = targetServices.constBegin(); iter != targetServices.constEnd(); ++iter) {
+        controller->executeScript(commandName, getServiceArguments(*iter, commandArgs), *iter);
+    }
+}
+
+QStringList MainWindow::getServiceArguments(MicroserviceData *microservice, const QStringList &commandArgs) const {
+    QStringList args;
+    args << microservice->getFolderName()
+         << microservice->getShortName()
+         << microservice->getPIDByPorts()
+         << commandArgs
+         << microservice->getEnabledFlags();
+    return args;
+}
+
+void MainWindow::convergeToSave(const QString &saveName) {
+    TraceSpan span("MainWindow::convergeToSave", "command", saveName);
+    QString startCommand = controller->getCommandForRole(CommandRole::Start);
+    QString stopCommand = controller->getCommandForRole(CommandRole::Stop);
+    if (startCommand.isEmpty()) {
+        QMessageBox::warning(this, "Converge", "No command with role=start is executed for selected services.");
+        return;
+    }
+
+    QStringList startArgs;
+    if (!controller->getCommandArgs(startCommand).isEmpty()) {
+        startArgs = getCommandArguments(startCommand);
+        if (startArgs.isEmpty()) {
+            return;
+        }
+    }
+
+    QStringList stopArgs;
+    if (!stopCommand.isEmpty() && !controller->getCommandArgs(stopCommand).isEmpty()) {
+        stopArgs = getCommandArguments(stopCommand);
+        if (stopArgs.isEmpty()) {
+            return;
+        }
+    }
+
+    QStringList savedServices = controller->getSaveServices(saveName);
+    QSet<QString> wanted(savedServices.constBegin(), savedServices.constEnd());
+    QStringList startExcluded = controller->getCommandExcludedServices(startCommand);
+    QStringList stopExcluded = stopCommand.isEmpty() ? QStringList() : controller->getCommandExcludedServices(stopCommand);
+
+    // The delta is computed from one fresh status snapshot
+    ProcessTree processTree = ProcessTree::snapshot();
+    QVector<MicroserviceData*> toStart;
+    QVector<MicroserviceData*> toStop;
+    QStringList untouched;
+
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
+        MicroserviceData *microservice = iter.value();
+        microservice->refreshCheckboxState(processTree);
+        MicroserviceStatus status = microservice->getStatus();
+
+        if (wanted.contains(iter.key())) {
+            if (status == MicroserviceStatus::Inactive && !startExcluded.contains(iter.key())) {
+                toStart.append(microservice);
+            }
+        } else if (status == MicroserviceStatus::Debug) {
+            untouched << iter.key() + " (debug)"; // Probably run from an IDE, so it is left alone
+        } else if (status == MicroserviceStatus::Active) {
+            if (stopExcluded.contains(iter.key())) {
+                untouched << iter.key() + " (excluded)";
+            } else {
+                toStop.append(microservice);
+            }
+        }
+    }
+
+    controller->selectDetermined(saveName);
+    updateServicesStatus();
+
+    if (toStart.isEmpty() && toStop.isEmpty()) {
+        statusBar()->showMessage(QString("Already converged to %1").arg(saveName), 10000);
+        return;
+    }
 
-        QStringList args;
-        args << processName
-             << iter.value()->getShortName()
-             << pid
-             << commandArgs
-             << iter.value()->getEnabledFlags();
+    qDebug() << "Converging to" << saveName << "- start:" << toStart.size() << "stop:" << toStop.size() << "left running:" << untouched;
 
-        controller->executeScript(commandName, args);
+    struct ConvergeProgress {
+        int pending = 0;
+        QStringList started;
+        QStringList stopped;
+        QStringList failed;
+    };
+
+    QSharedPointer<ConvergeProgress> progress(new ConvergeProgress);
+    progress->pending = toStart.size() + toStop.size();
+
+    auto finish = [this, progress, saveName, untouched](const QString &serviceName, bool start, int exitCode) {
+        if (exitCode != 0) {
+            progress->failed << serviceName;
+        } else {
+            (start ? progress->started : progress->stopped) << serviceName;
+        }
+
+        if (--progress->pending > 0) {
+            return;
+        }
+
+        onRefreshButtonClicked();
+        statusBar()->showMessage(QString("Converged to %1: started %2, stopped %3%4%5")
+            .arg(saveName)
+            .arg(progress->started.isEmpty() ? "none" : progress->started.join(", "))
+            .arg(progress->stopped.isEmpty() ? "none" : progress->stopped.join(", "))
+            .arg(progress->failed.isEmpty() ? QString() : ", failed: " + progress->failed.join(", "))
+            .arg(untouched.isEmpty() ? QString() : ", left running: " + untouched.join(", ")), 20000);
+    };
+
+    statusBar()->showMessage(QString("Converging to %1: starting %2, stopping %3 services...").arg(saveName).arg(toStart.size()).arg(toStop.size()));
+
+    // Both halves run at the same time; every script reports back on its own
+    if (stopCommand.isEmpty() && !toStop.isEmpty()) {
+        qDebug() << "No command with role=stop, stopping natively";
+        GracefulStop *gracefulStop = controller->stopServices(toStop);
+        connect(gracefulStop, &GracefulStop::finished, this, [finish, gracefulStop]() {
+            foreach (const QString &serviceName, gracefulStop->getStopped() + gracefulStop->getForced()) {
+                finish(serviceName, false, 0);
+            }
+            foreach (const QString &serviceName, gracefulStop->getSurvivors()) {
+                finish(serviceName, false, 1);
+            }
+        });
+    } else {
+        for (auto iter = toStop.constBegin(); iter != toStop.constEnd(); ++iter) {
+            QString serviceName = (*iter)->getName();
+            controller->executeScriptAsync(stopCommand, getServiceArguments(*iter, stopArgs), *iter, [finish, serviceName](int exitCode) {
+                finish(serviceName, false, exitCode);
+            });
+        }
+    }
+
+    for (auto iter = toStart.constBegin(); iter != toStart.constEnd(); ++iter) {
+        QString serviceName = (*iter)->getName();
+        controller->executeScriptAsync(startCommand, getServiceArguments(*iter, startArgs), *iter, [finish, serviceName](int exitCode) {
+            finish(serviceName, true, exitCode);
+        });
     }
 }
 
@@ -569,12 +1178,13 @@ void MainWindow::onSaveActionClicked(const QString &saveName) {
 }
 
 void MainWindow::onSearchLineEditTextChanged() {
+    TraceSpan span("MainWindow::onSearchLineEditTextChanged", "ui");
     QString searchText = searchLineEdit->text();
     QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
     for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
         QCheckBox* checkBox = iter.value()->getCheckBox();
         QCheckBox* statusCheckBox = iter.value()->getStatusCheckBox();
-        bool matchesSearch = searchText.isEmpty() || checkBox->text().contains(searchText, Qt::CaseInsensitive);
+        bool matchesSearch = iter.value()->matches(searchText);
         checkBox->setVisible(matchesSearch);
         statusCheckBox->setVisible(matchesSearch);
 
@@ -688,6 +1298,7 @@ bool MainWindow::eventFilter(QObject* obj, QEvent* event) {
 }
 
 void MainWindow::saveCheckBoxStateToFile() {
+    TraceSpan span("MainWindow::saveCheckBoxStateToFile", "config");
     QSettings settings(model->getSaveFile(), QSettings::IniFormat);
     settings.beginGroup("CheckBoxState");
 
@@ -708,6 +1319,8 @@ void MainWindow::saveCheckBoxStateToFile() {
     settings.endGroup();
 
     saveFlagsStateToFile();
+    saveLaunchSessionsToFile();
+    model->saveSnapshot();
 }
 
 void MainWindow::saveFlagsStateToFile() {
@@ -722,8 +1335,8 @@ void MainWindow::saveFlagsStateToFile() {
     for (iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
         settings.beginGroup("Flag_" + iter.key());
 
-        foreach (QCheckBox *checkBox, iter.value()->getFlagCheckBoxes()) {
-            settings.setValue(checkBox->text(), checkBox->isChecked());
+        foreach (const QString &flag, model->getFlagNames()) {
+            settings.setValue(flag, iter.value()->isFlagEnabled(flag));
         }
 
         settings.endGroup();
@@ -734,7 +1347,8 @@ void MainWindow::onFlagControlPanelStateChanged(bool enabled) {
     QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
     QMap<QString, MicroserviceData*>::const_iterator iter;
     for (iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter) {
-        iter.value()->setFlagsVisible(enabled);
+        // Rows hidden by the search get their checkboxes when they match again
+        iter.value()->setFlagsVisible(enabled && !iter.value()->getCheckBox()->isHidden());
     }
 }
 
@@ -774,7 +1388,7 @@ void MainWindow::onAddFlagClicked() {
     QString newFlag = flagLineEdit->text();
 
     model->addFlagName(newFlag);
-    controller->addFlag(newFlag, showFlagControlPanelCheckBox->isChecked());
+    controller->addFlag(newFlag);
 
     QAction *applyFlagAction = new QAction(newFlag, this);
     connect(applyFlagAction, &QAction::triggered, this, [this, newFlag]() {
@@ -797,6 +1411,123 @@ void MainWindow::onRemoveFlagFromAllServicesClicked(const QString &flag) {
     controller->updateFlagStateForAllServices(flag, Qt::Unchecked);
 }
 
+void MainWindow::showStatusHistoryDialog() {
+    TraceSpan span("MainWindow::showStatusHistoryDialog", "ui");
+    StatusHistory *history = StatusHistory::instance();
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    auto formatDuration = [](qint64 ms) {
+        if (ms < 0) {
+            return QString("-");
+        }
+
+        qint64 seconds = ms / 1000;
+        if (seconds < 60) {
+            return QString::number(ms / 1000.0, 'f', 1) + " s";
+        }
+
+        if (seconds < 3600) {
+            return QString("%1 min %2 s").arg(seconds / 60).arg(seconds % 60);
+        }
+
+        return QString("%1 h %2 min").arg(seconds / 3600).arg(seconds % 3600 / 60);
+    };
+
+    auto formatTime = [](qint64 ms) {
+        return ms > 0 ? QDateTime::fromMSecsSinceEpoch(ms).toString("yyyy-MM-dd hh:mm:ss") : QString("-");
+    };
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Status History");
+    dialog.resize(900, 600);
+
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+
+    QTableWidget *servicesTable = new QTableWidget(&dialog);
+    servicesTable->setColumnCount(7);
+    servicesTable->setHorizontalHeaderLabels({"Service", "Status", "Uptime", "Restarts", "Last down", "Ready p50", "Ready p95"});
+    servicesTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    servicesTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    servicesTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    servicesTable->verticalHeader()->setVisible(false);
+
+    QMap<QString, MicroserviceData*> microservicesMap = model->getMicroservices().getDataMap();
+    servicesTable->setRowCount(microservicesMap.size());
+
+    int row = 0;
+    for (auto iter = microservicesMap.constBegin(); iter != microservicesMap.constEnd(); ++iter, ++row) {
+        ServiceStatistics statistics = history->getStatistics(iter.key());
+        QString readySamples = QString(" (%1)").arg(statistics.readySamples);
+
+        servicesTable->setItem(row, 0, new QTableWidgetItem(iter.key()));
+        servicesTable->setItem(row, 1, new QTableWidgetItem(microserviceStatusToString(iter.value()->getStatus())));
+        servicesTable->setItem(row, 2, new QTableWidgetItem(statistics.upSinceMs > 0 ? formatDuration(now - statistics.upSinceMs) : QString("-")));
+        servicesTable->setItem(row, 3, new QTableWidgetItem(QString::number(statistics.restarts)));
+        servicesTable->setItem(row, 4, new QTableWidgetItem(formatTime(statistics.lastDownMs)));
+        servicesTable->setItem(row, 5, new QTableWidgetItem(formatDuration(statistics.readyP50Ms) + (statistics.readySamples > 0 ? readySamples : QString())));
+        servicesTable->setItem(row, 6, new QTableWidgetItem(formatDuration(statistics.readyP95Ms)));
+    }
+
+    servicesTable->resizeColumnsToContents();
+    layout->addWidget(servicesTable, 2);
+
+    QLabel *eventsLabel = new QLabel("Events of the last 7 days", &dialog);
+    layout->addWidget(eventsLabel);
+
+    QTableWidget *eventsTable = new QTableWidget(&dialog);
+    eventsTable->setColumnCount(2);
+    eventsTable->setHorizontalHeaderLabels({"Time", "Event"});
+    eventsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    eventsTable->verticalHeader()->setVisible(false);
+    eventsTable->horizontalHeader()->setStretchLastSection(true);
+    layout->addWidget(eventsTable, 1);
+
+    connect(servicesTable, &QTableWidget::itemSelectionChanged, &dialog, [=]() {
+        QList<QTableWidgetItem*> selected = servicesTable->selectedItems();
+        if (selected.isEmpty()) {
+            return;
+        }
+
+        QString serviceName = servicesTable->item(selected.first()->row(), 0)->text();
+        eventsLabel->setText("Events of the last 7 days: " + serviceName);
+
+        QVector<HistoryEvent> events = history->getEvents(serviceName, now - 7LL * 24 * 3600 * 1000, now);
+        eventsTable->setRowCount(events.size());
+
+        // Newest events first
+        for (int i = 0; i < events.size(); ++i) {
+            const HistoryEvent &event = events.at(events.size() - 1 - i);
+
+            QString description;
+            switch (event.type) {
+            case HistoryEventType::StatusChanged:
+                description = "Status changed to " + microserviceStatusToString(event.status);
+                break;
+            case HistoryEventType::StartIssued:
+                description = "Start command executed";
+                break;
+            case HistoryEventType::StopIssued:
+                description = "Stop command executed";
+                break;
+            case HistoryEventType::Ready:
+                description = "Ports are accepting connections";
+                break;
+            }
+
+            eventsTable->setItem(i, 0, new QTableWidgetItem(formatTime(event.timestampMs)));
+            eventsTable->setItem(i, 1, new QTableWidgetItem(description));
+        }
+
+        eventsTable->resizeColumnToContents(0);
+    });
+
+    QDialogButtonBox buttonBox(QDialogButtonBox::Close, Qt::Horizontal, &dialog);
+    layout->addWidget(&buttonBox);
+    QObject::connect(&buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    dialog.exec();
+}
+
 void MainWindow::showAboutDialog() {
     QMessageBox aboutBox(this);
     aboutBox.setWindowTitle("About");
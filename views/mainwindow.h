@@ -5,6 +5,7 @@
 #include <QVBoxLayout>
 #include <QLineEdit>
 #include <QScrollArea>
+#include <QSettings>
 
 #include "controllers/controller.h"
 
@@ -14,6 +15,12 @@ class MainWindow;
 }
 QT_END_NAMESPACE
 
+struct DiscoveryResult {
+    QVector<ServiceInfo> services;
+    ProcessTree processTree;
+    QHash<QString, ServiceProbe> probes; // statuses of the listed and the discovered services
+};
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -21,11 +28,13 @@ class MainWindow : public QMainWindow
 public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    void runBenchmark(const QString &resultsFile);
 
 private slots:
     void onSelectAllButtonClicked();
     void onDeselectAllButtonClicked();
     void onRefreshButtonClicked();
+    void onNativeStopButtonClicked();
     void onSaveActionClicked(const QString &saveName);
     void onSearchLineEditTextChanged();
     void onSearchLineEditEditingFinished();
@@ -44,11 +53,23 @@ private:
     void loadSavesFromConfigFile();
     void loadCommandsFromConfigFile();
     void loadMainWindowButtonsFromConfigFile();
+    void loadCheckBoxStateFromFile();
+    void loadLaunchSessionsFromFile();
+    void saveLaunchSessionsToFile();
     void saveCheckBoxStateToFile();
     void saveFlagsStateToFile();
     void updateServicesStatus();
+    void addMicroserviceLayout(MicroserviceData *microservice, QSettings &settings);
+    void startBackgroundDiscovery();
+    void applyDiscovery(const DiscoveryResult &result);
+    void queueDiscoveredService(const ServiceInfo &info);
+    void applyDiscoveredServices();
+    void addServiceRows(const QVector<MicroserviceData*> &microservices);
     QStringList getCommandArguments(const QString &commandName);
     void executeForSelectedMicroservices(const QString &commandName, const QStringList &commandArgs);
+    QStringList getServiceArguments(MicroserviceData *microservice, const QStringList &commandArgs) const;
+    void convergeToSave(const QString &saveName);
+    void showStatusHistoryDialog();
     void showAboutDialog();
 
     Ui::MainWindow *ui;
@@ -69,6 +90,8 @@ private:
     QMenu *applyFlagsToAllServicesSubMenu;
     QMenu *removeFlagsFromAllServicesSubMenu;
     QLabel *servicesStatusLabel;
+    QVector<ServiceInfo> discoveredServices;
+    QHash<QString, int> savedLaunchSessions;
 
     int width;
     int height;